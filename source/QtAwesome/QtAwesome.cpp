@@ -13,58 +13,84 @@
 #include <QDebug>
 #include <QFile>
 #include <QFontDatabase>
+#include <QPixmapCache>
 
+#include <algorithm>
+
+
+
+QtAwesomeIconOptions::QtAwesomeIconOptions()
+    : scaleFactor(1.0)
+    , anim(0)
+{
+}
+
+/// Creates the typed options from an option map (normally the defaults merged with the icon's own options)
+QtAwesomeIconOptions QtAwesomeIconOptions::fromVariantMap( const QVariantMap& options )
+{
+    static const char* const modeSuffixes[ModeCount] = { "", "-disabled", "-active", "-selected" };
+
+    QtAwesomeIconOptions result;
+    for( int mode = 0; mode < ModeCount; ++mode ) {
+        result.color[mode] = options.value( QString("color") + modeSuffixes[mode] ).value<QColor>();
+        if( mode != QIcon::Normal ) {
+            result.text[mode] = options.value( QString("text") + modeSuffixes[mode] ).toString();
+        }
+    }
+    result.scaleFactor = options.value("scale-factor").toDouble();
+    result.anim = qobject_cast<QtAwesomeAnimation*>( qvariant_cast<QObject*>(options.value("anim")) );
+    return result;
+}
+
+bool QtAwesomeIconOptions::operator==( const QtAwesomeIconOptions& other ) const
+{
+    for( int mode = 0; mode < ModeCount; ++mode ) {
+        if( color[mode] != other.color[mode] || text[mode] != other.text[mode] ) {
+            return false;
+        }
+    }
+    return scaleFactor == other.scaleFactor && anim == other.anim;
+}
+
+uint qHash( const QtAwesomeIconOptions& options, uint seed )
+{
+    for( int mode = 0; mode < QtAwesomeIconOptions::ModeCount; ++mode ) {
+        seed = qHash( options.color[mode].rgba(), seed ) ^ qHash( options.text[mode], seed );
+    }
+    return qHash( options.scaleFactor, seed ) ^ qHash( options.anim, seed );
+}
+
+
+//---------------------------------------------------------------------------------------
 
 
 /// The font-awesome icon painter
 class QtAwesomeCharIconPainter: public QtAwesomeIconPainter
 {
 public:
+    /// Compatibility path for callers that paint with an option map
     virtual void paint( QtAwesome* awesome, QPainter* painter, const QRect& rect, QIcon::Mode mode, QIcon::State state, const QVariantMap& options  )
     {
-        Q_UNUSED(mode);
         Q_UNUSED(state);
-        Q_UNUSED(options);
+        paintChar( awesome, painter, rect, mode, options.value("text").toString(), QtAwesomeIconOptions::fromVariantMap(options) );
+    }
 
+    static void paintChar( QtAwesome* awesome, QPainter* painter, const QRect& rect, QIcon::Mode mode, const QString& text, const QtAwesomeIconOptions& options )
+    {
         painter->save();
 
-        QObject* qanim = qvariant_cast<QObject*>(options.value("anim"));
-        QtAwesomeAnimation* anim = qobject_cast<QtAwesomeAnimation*>(qanim);
-        if( anim ) {
-            anim->setup( *painter, rect );
+        if( options.anim ) {
+            options.anim->setup( *painter, rect );
         }
 
-
         // set the correct color
-        QColor color = options.value("color").value<QColor>();
-        QString text = options.value("text").toString();
-
-        if( mode == QIcon::Disabled ) {
-            color = options.value("color-disabled").value<QColor>();
-            QVariant alt = options.value("text-disabled");
-            if( alt.isValid() ) {
-                text = alt.toString();
-            }
-        } else if( mode == QIcon::Active ) {
-            color = options.value("color-active").value<QColor>();
-            QVariant alt = options.value("text-active");
-            if( alt.isValid() ) {
-                text = alt.toString();
-            }
-        } else if( mode == QIcon::Selected ) {
-            color = options.value("color-selected").value<QColor>();
-            QVariant alt = options.value("text-selected");
-            if( alt.isValid() ) {
-                text = alt.toString();
-            }
-        }
-        painter->setPen(color);
+        painter->setPen( options.color[mode] );
 
         // add some 'padding' around the icon
-        int drawSize = qRound(rect.height()*options.value("scale-factor").toFloat());
+        int drawSize = qRound(rect.height()*options.scaleFactor);
 
         painter->setFont( awesome->font(drawSize) );
-        painter->drawText( rect, text, QTextOption( Qt::AlignCenter|Qt::AlignVCenter ) );
+        painter->drawText( rect, options.modeText(mode, text), QTextOption( Qt::AlignCenter|Qt::AlignVCenter ) );
         painter->restore();
     }
 
@@ -74,6 +100,65 @@ public:
 //---------------------------------------------------------------------------------------
 
 
+/// The icon engine for font icons, painting with the shared typed options.
+class QtAwesomeCharIconEngine : public QIconEngine
+{
+
+public:
+
+    QtAwesomeCharIconEngine( QtAwesome* awesome, const QString& text, const QSharedPointer<const QtAwesomeIconOptions>& options )
+        : awesomeRef_(awesome)
+        , text_(text)
+        , options_(options)
+    {
+    }
+
+    virtual ~QtAwesomeCharIconEngine() {}
+
+    QtAwesomeCharIconEngine* clone() const
+    {
+        return new QtAwesomeCharIconEngine( awesomeRef_, text_, options_ );
+    }
+
+    virtual void paint(QPainter* painter, const QRect& rect, QIcon::Mode mode, QIcon::State state)
+    {
+        Q_UNUSED( state );
+        QtAwesomeCharIconPainter::paintChar( awesomeRef_, painter, rect, mode, text_, *options_ );
+    }
+
+    virtual QPixmap pixmap(const QSize& size, QIcon::Mode mode, QIcon::State state)
+    {
+        // identical icons share a single rasterised pixmap
+        QString key = awesomeRef_->pixmapCacheKey( text_, *options_, size, mode, state );
+        QPixmap pm;
+        if( !key.isEmpty() && QPixmapCache::find( key, &pm ) ) {
+            return pm;
+        }
+
+        pm = QPixmap(size);
+        pm.fill( Qt::transparent ); // we need transparency
+        {
+            QPainter p(&pm);
+            paint(&p, QRect(QPoint(0,0),size), mode, state);
+        }
+
+        if( !key.isEmpty() ) {
+            QPixmapCache::insert( key, pm );
+        }
+        return pm;
+    }
+
+private:
+
+    QtAwesome* awesomeRef_;                                 ///< a reference to the QtAwesome instance
+    QString text_;                                          ///< the character(s) to paint
+    QSharedPointer<const QtAwesomeIconOptions> options_;    ///< the interned options
+};
+
+
+//---------------------------------------------------------------------------------------
+
+
 /// The painter icon engine.
 class QtAwesomeIconPainterIconEngine : public QIconEngine
 {
@@ -126,6 +211,8 @@ private:
 QtAwesome::QtAwesome( QObject* parent )
     : QObject( parent )
     , namedCodepoints_()
+    , fontAwesomeNames_(false)
+    , fontAwesomePending_(false)
 {
     // initialize the default options
     setDefaultOption( "color", QColor(50,50,50) );
@@ -155,6 +242,7 @@ QtAwesome::~QtAwesome()
 void QtAwesome::init(const QString& fontname)
 {
     fontName_ = fontname;
+    iconCache_.clear();
 }
 
 struct FANameIcon {
@@ -162,8 +250,7 @@ struct FANameIcon {
   fa::icon icon;
 };
 
-static const FANameIcon faNameIconArray[] = {
-      { "fa_500px"                         , fa::fa_500px                         },
+static constexpr FANameIcon faNameIconArray[] = {
       { "addressbook"                      , fa::addressbook                      },
       { "addressbooko"                     , fa::addressbooko                     },
       { "addresscard"                      , fa::addresscard                      },
@@ -202,11 +289,11 @@ static const FANameIcon faNameIconArray[] = {
       { "arrowdown"                        , fa::arrowdown                        },
       { "arrowleft"                        , fa::arrowleft                        },
       { "arrowright"                       , fa::arrowright                       },
-      { "arrowup"                          , fa::arrowup                          },
       { "arrows"                           , fa::arrows                           },
       { "arrowsalt"                        , fa::arrowsalt                        },
       { "arrowsh"                          , fa::arrowsh                          },
       { "arrowsv"                          , fa::arrowsv                          },
+      { "arrowup"                          , fa::arrowup                          },
       { "aslinterpreting"                  , fa::aslinterpreting                  },
       { "assistivelisteningsystems"        , fa::assistivelisteningsystems        },
       { "asterisk"                         , fa::asterisk                         },
@@ -338,9 +425,9 @@ static const FANameIcon faNameIconArray[] = {
       { "cogs"                             , fa::cogs                             },
       { "columns"                          , fa::columns                          },
       { "comment"                          , fa::comment                          },
-      { "commento"                         , fa::commento                         },
       { "commenting"                       , fa::commenting                       },
       { "commentingo"                      , fa::commentingo                      },
+      { "commento"                         , fa::commento                         },
       { "comments"                         , fa::comments                         },
       { "commentso"                        , fa::commentso                        },
       { "compass"                          , fa::compass                          },
@@ -404,9 +491,12 @@ static const FANameIcon faNameIconArray[] = {
       { "externallink"                     , fa::externallink                     },
       { "externallinksquare"               , fa::externallinksquare               },
       { "eye"                              , fa::eye                              },
-      { "eyeslash"                         , fa::eyeslash                         },
       { "eyedropper"                       , fa::eyedropper                       },
+      { "eyeslash"                         , fa::eyeslash                         },
       { "fa"                               , fa::fa                               },
+      { "fa_500px"                         , fa::fa_500px                         },
+      { "fa_linux"                         , fa::fa_linux                         },
+      { "fa_try"                           , fa::fa_try                           },
       { "facebook"                         , fa::facebook                         },
       { "facebookf"                        , fa::facebookf                        },
       { "facebookofficial"                 , fa::facebookofficial                 },
@@ -429,13 +519,13 @@ static const FANameIcon faNameIconArray[] = {
       { "filephotoo"                       , fa::filephotoo                       },
       { "filepictureo"                     , fa::filepictureo                     },
       { "filepowerpointo"                  , fa::filepowerpointo                  },
+      { "fileso"                           , fa::fileso                           },
       { "filesoundo"                       , fa::filesoundo                       },
       { "filetext"                         , fa::filetext                         },
       { "filetexto"                        , fa::filetexto                        },
       { "filevideoo"                       , fa::filevideoo                       },
       { "filewordo"                        , fa::filewordo                        },
       { "filezipo"                         , fa::filezipo                         },
-      { "fileso"                           , fa::fileso                           },
       { "film"                             , fa::film                             },
       { "filter"                           , fa::filter                           },
       { "fire"                             , fa::fire                             },
@@ -475,11 +565,11 @@ static const FANameIcon faNameIconArray[] = {
       { "ggcircle"                         , fa::ggcircle                         },
       { "gift"                             , fa::gift                             },
       { "git"                              , fa::git                              },
-      { "gitsquare"                        , fa::gitsquare                        },
       { "github"                           , fa::github                           },
       { "githubalt"                        , fa::githubalt                        },
       { "githubsquare"                     , fa::githubsquare                     },
       { "gitlab"                           , fa::gitlab                           },
+      { "gitsquare"                        , fa::gitsquare                        },
       { "gittip"                           , fa::gittip                           },
       { "glass"                            , fa::glass                            },
       { "glide"                            , fa::glide                            },
@@ -495,7 +585,6 @@ static const FANameIcon faNameIconArray[] = {
       { "gratipay"                         , fa::gratipay                         },
       { "grav"                             , fa::grav                             },
       { "group"                            , fa::group                            },
-      { "hsquare"                          , fa::hsquare                          },
       { "hackernews"                       , fa::hackernews                       },
       { "handgrabo"                        , fa::handgrabo                        },
       { "handlizardo"                      , fa::handlizardo                      },
@@ -508,17 +597,17 @@ static const FANameIcon faNameIconArray[] = {
       { "handpointero"                     , fa::handpointero                     },
       { "handrocko"                        , fa::handrocko                        },
       { "handscissorso"                    , fa::handscissorso                    },
+      { "handshakeo"                       , fa::handshakeo                       },
       { "handspocko"                       , fa::handspocko                       },
       { "handstopo"                        , fa::handstopo                        },
-      { "handshakeo"                       , fa::handshakeo                       },
       { "hardofhearing"                    , fa::hardofhearing                    },
       { "hashtag"                          , fa::hashtag                          },
       { "hddo"                             , fa::hddo                             },
       { "header"                           , fa::header                           },
       { "headphones"                       , fa::headphones                       },
       { "heart"                            , fa::heart                            },
-      { "hearto"                           , fa::hearto                           },
       { "heartbeat"                        , fa::heartbeat                        },
+      { "hearto"                           , fa::hearto                           },
       { "history"                          , fa::history                          },
       { "home"                             , fa::home                             },
       { "hospitalo"                        , fa::hospitalo                        },
@@ -532,6 +621,7 @@ static const FANameIcon faNameIconArray[] = {
       { "hourglasso"                       , fa::hourglasso                       },
       { "hourglassstart"                   , fa::hourglassstart                   },
       { "houzz"                            , fa::houzz                            },
+      { "hsquare"                          , fa::hsquare                          },
       { "html5"                            , fa::html5                            },
       { "icursor"                          , fa::icursor                          },
       { "idbadge"                          , fa::idbadge                          },
@@ -578,7 +668,6 @@ static const FANameIcon faNameIconArray[] = {
       { "linkedin"                         , fa::linkedin                         },
       { "linkedinsquare"                   , fa::linkedinsquare                   },
       { "linode"                           , fa::linode                           },
-      { "fa_linux"                         , fa::fa_linux                         },
       { "list"                             , fa::list                             },
       { "listalt"                          , fa::listalt                          },
       { "listol"                           , fa::listol                           },
@@ -644,9 +733,9 @@ static const FANameIcon faNameIconArray[] = {
       { "outdent"                          , fa::outdent                          },
       { "pagelines"                        , fa::pagelines                        },
       { "paintbrush"                       , fa::paintbrush                       },
+      { "paperclip"                        , fa::paperclip                        },
       { "paperplane"                       , fa::paperplane                       },
       { "paperplaneo"                      , fa::paperplaneo                      },
-      { "paperclip"                        , fa::paperclip                        },
       { "paragraph"                        , fa::paragraph                        },
       { "paste"                            , fa::paste                            },
       { "pause"                            , fa::pause                            },
@@ -746,11 +835,11 @@ static const FANameIcon faNameIconArray[] = {
       { "shoppingbasket"                   , fa::shoppingbasket                   },
       { "shoppingcart"                     , fa::shoppingcart                     },
       { "shower"                           , fa::shower                           },
+      { "signal"                           , fa::signal                           },
       { "signin"                           , fa::signin                           },
+      { "signing"                          , fa::signing                          },
       { "signlanguage"                     , fa::signlanguage                     },
       { "signout"                          , fa::signout                          },
-      { "signal"                           , fa::signal                           },
-      { "signing"                          , fa::signing                          },
       { "simplybuilt"                      , fa::simplybuilt                      },
       { "sitemap"                          , fa::sitemap                          },
       { "skyatlas"                         , fa::skyatlas                         },
@@ -825,8 +914,6 @@ static const FANameIcon faNameIconArray[] = {
       { "textheight"                       , fa::textheight                       },
       { "textwidth"                        , fa::textwidth                        },
       { "th"                               , fa::th                               },
-      { "thlarge"                          , fa::thlarge                          },
-      { "thlist"                           , fa::thlist                           },
       { "themeisle"                        , fa::themeisle                        },
       { "thermometer"                      , fa::thermometer                      },
       { "thermometer0"                     , fa::thermometer0                     },
@@ -839,11 +926,13 @@ static const FANameIcon faNameIconArray[] = {
       { "thermometerhalf"                  , fa::thermometerhalf                  },
       { "thermometerquarter"               , fa::thermometerquarter               },
       { "thermometerthreequarters"         , fa::thermometerthreequarters         },
-      { "thumbtack"                        , fa::thumbtack                        },
+      { "thlarge"                          , fa::thlarge                          },
+      { "thlist"                           , fa::thlist                           },
       { "thumbsdown"                       , fa::thumbsdown                       },
       { "thumbsodown"                      , fa::thumbsodown                      },
       { "thumbsoup"                        , fa::thumbsoup                        },
       { "thumbsup"                         , fa::thumbsup                         },
+      { "thumbtack"                        , fa::thumbtack                        },
       { "ticket"                           , fa::ticket                           },
       { "times"                            , fa::times                            },
       { "timescircle"                      , fa::timescircle                      },
@@ -868,7 +957,6 @@ static const FANameIcon faNameIconArray[] = {
       { "tripadvisor"                      , fa::tripadvisor                      },
       { "trophy"                           , fa::trophy                           },
       { "truck"                            , fa::truck                            },
-      { "fa_try"                           , fa::fa_try                           },
       { "tty"                              , fa::tty                              },
       { "tumblr"                           , fa::tumblr                           },
       { "tumblrsquare"                     , fa::tumblrsquare                     },
@@ -895,9 +983,9 @@ static const FANameIcon faNameIconArray[] = {
       { "usermd"                           , fa::usermd                           },
       { "usero"                            , fa::usero                            },
       { "userplus"                         , fa::userplus                         },
+      { "users"                            , fa::users                            },
       { "usersecret"                       , fa::usersecret                       },
       { "usertimes"                        , fa::usertimes                        },
-      { "users"                            , fa::users                            },
       { "vcard"                            , fa::vcard                            },
       { "vcardo"                           , fa::vcardo                           },
       { "venus"                            , fa::venus                            },
@@ -938,10 +1026,10 @@ static const FANameIcon faNameIconArray[] = {
       { "wrench"                           , fa::wrench                           },
       { "xing"                             , fa::xing                             },
       { "xingsquare"                       , fa::xingsquare                       },
-      { "ycombinator"                      , fa::ycombinator                      },
-      { "ycombinatorsquare"                , fa::ycombinatorsquare                },
       { "yahoo"                            , fa::yahoo                            },
       { "yc"                               , fa::yc                               },
+      { "ycombinator"                      , fa::ycombinator                      },
+      { "ycombinatorsquare"                , fa::ycombinatorsquare                },
       { "ycsquare"                         , fa::ycsquare                         },
       { "yelp"                             , fa::yelp                             },
       { "yen"                              , fa::yen                              },
@@ -951,14 +1039,68 @@ static const FANameIcon faNameIconArray[] = {
       { "youtubesquare"                    , fa::youtubesquare                    }
 };
 
+static constexpr int faNameIconCount = sizeof(faNameIconArray)/sizeof(FANameIcon);
+
+// compile-time strcmp, for checking the table order
+static constexpr int compareNames( const char* a, const char* b )
+{
+    return *a != *b ? (static_cast<unsigned char>(*a) < static_cast<unsigned char>(*b) ? -1 : 1)
+                    : (*a == '\0' ? 0 : compareNames(a + 1, b + 1));
+}
+
+// checks each neighbouring pair in [first,last], splitting the range so the recursion stays shallow
+static constexpr bool namesSorted( int first, int last )
+{
+    return last - first < 1 ? true
+         : last - first == 1 ? compareNames(faNameIconArray[first].name, faNameIconArray[last].name) < 0
+         : namesSorted(first, first + (last - first) / 2) && namesSorted(first + (last - first) / 2, last);
+}
+
+static_assert( namesSorted(0, faNameIconCount - 1), "faNameIconArray must be sorted by name (and the names unique) for the binary search" );
+
+/// Finds a font-awesome icon by name in the static table, returns -1 if there's no such icon
+static int findFontAwesomeName( const QString& name )
+{
+    const QByteArray key = name.toLatin1();
+    const FANameIcon* end = faNameIconArray + faNameIconCount;
+    const FANameIcon* itr = std::lower_bound( faNameIconArray, end, key.constData(), [](const FANameIcon& entry, const char* value) {
+        return qstrcmp( entry.name, value ) < 0;
+    });
+
+    if( itr != end && qstrcmp( itr->name, key.constData() ) == 0 ) {
+        return itr->icon;
+    }
+    return -1;
+}
+
 
 /// a specialized init function so font-awesome is loaded and initialized
 /// this method return true on success, it will return false if the fnot cannot be initialized
 /// To initialize QtAwesome with font-awesome you need to call this method
-bool QtAwesome::initFontAwesome( )
+///
+/// With lazy set the font isn't read or registered until the first call to font(), normally when
+/// the first icon is painted, so creating icons (e.g. while building the UI) costs nothing up front.
+/// Failures to load the font are then only reported in the debug output.
+bool QtAwesome::initFontAwesome( bool lazy )
+{
+    if( lazy ) {
+        fontName_ = "FontAwesome";
+        fontAwesomePending_ = true;
+        fontAwesomeNames_ = true;
+        iconCache_.clear();
+        return true;
+    }
+
+    return loadFontAwesome();
+}
+
+/// reads the font-awesome font from the resources and registers it with the font database
+bool QtAwesome::loadFontAwesome()
 {
     static int fontAwesomeFontId = -1;
 
+    fontAwesomePending_ = false;
+
     // only load font-awesome once
     if( fontAwesomeFontId < 0 ) {
 
@@ -992,15 +1134,29 @@ bool QtAwesome::initFontAwesome( )
         return false;
     }
 
-    // intialize the map
-    QHash<QString, int>& m = namedCodepoints_;
-    for (unsigned i = 0; i < sizeof(faNameIconArray)/sizeof(FANameIcon); ++i) {
-      m.insert(faNameIconArray[i].name, faNameIconArray[i].icon);
-    }
+    // the names are looked up in the static table, nothing needs building
+    fontAwesomeNames_ = true;
 
     return true;
 }
 
+/// Returns all of the named code-points: the font-awesome names and those added with addNamedCodepoint
+/// This builds the map, so it's meant for listing the icons rather than looking them up
+QHash<QString,int> QtAwesome::namedCodePoints()
+{
+    QHash<QString,int> result;
+    if( fontAwesomeNames_ ) {
+        result.reserve( faNameIconCount + namedCodepoints_.size() );
+        for( int i = 0; i < faNameIconCount; ++i ) {
+            result.insert( QString::fromLatin1(faNameIconArray[i].name), faNameIconArray[i].icon );
+        }
+    }
+    for( QHash<QString,int>::const_iterator itr = namedCodepoints_.constBegin(); itr != namedCodepoints_.constEnd(); ++itr ) {
+        result.insert( itr.key(), itr.value() );
+    }
+    return result;
+}
+
 void QtAwesome::addNamedCodepoint( const QString& name, int codePoint)
 {
     namedCodepoints_.insert( name, codePoint);
@@ -1011,6 +1167,8 @@ void QtAwesome::addNamedCodepoint( const QString& name, int codePoint)
 void QtAwesome::setDefaultOption(const QString& name, const QVariant& value)
 {
     defaultOptions_.insert( name, value );
+    defaultIconOptions_.clear();
+    iconCache_.clear();     // the cached icons hold the old defaults
 }
 
 
@@ -1042,11 +1200,30 @@ static QVariantMap mergeOptions( const QVariantMap& defaults, const QVariantMap&
 /// </code>
 QIcon QtAwesome::icon(int character, const QVariantMap &options)
 {
-    // create a merged QVariantMap to have default options and icon-specific options
-    QVariantMap optionMap = mergeOptions( defaultOptions_, options );
-    optionMap.insert("text", QString( QChar(static_cast<int>(character)) ) );
+    // icons with the default options are by far the most common, so only one is made per character
+    if( options.isEmpty() ) {
+        QHash<int,QIcon>::const_iterator itr = iconCache_.constFind( character );
+        if( itr != iconCache_.constEnd() ) {
+            return itr.value();
+        }
+    }
 
-    return icon( fontIconPainter_, optionMap );
+    // the option map is only merged and converted when it overrides the defaults
+    QSharedPointer<const QtAwesomeIconOptions> typedOptions;
+    if( options.isEmpty() ) {
+        if( !defaultIconOptions_ ) {
+            defaultIconOptions_ = internOptions( QtAwesomeIconOptions::fromVariantMap(defaultOptions_) );
+        }
+        typedOptions = defaultIconOptions_;
+    } else {
+        typedOptions = internOptions( QtAwesomeIconOptions::fromVariantMap( mergeOptions(defaultOptions_, options) ) );
+    }
+
+    QIcon result( new QtAwesomeCharIconEngine( this, QString( QChar(static_cast<int>(character)) ), typedOptions ) );
+    if( options.isEmpty() ) {
+        iconCache_.insert( character, result );
+    }
+    return result;
 }
 
 
@@ -1059,8 +1236,15 @@ QIcon QtAwesome::icon(int character, const QVariantMap &options)
 QIcon QtAwesome::icon(const QString& name, const QVariantMap& options)
 {
     // when it's a named codepoint
-    if( namedCodepoints_.count(name) ) {
-        return icon( namedCodepoints_.value(name), options );
+    QHash<QString,int>::const_iterator named = namedCodepoints_.constFind( name );
+    if( named != namedCodepoints_.constEnd() ) {
+        return icon( named.value(), options );
+    }
+    if( fontAwesomeNames_ ) {
+        int character = findFontAwesomeName( name );
+        if( character >= 0 ) {
+            return icon( character, options );
+        }
     }
 
 
@@ -1107,7 +1291,42 @@ void QtAwesome::give(const QString& name, QtAwesomeIconPainter* painter)
 ///    label->setFont( awesome->font(16) )
 QFont QtAwesome::font( int size )
 {
+    if( fontAwesomePending_ && !loadFontAwesome() ) {
+        qDebug() << "Font awesome font could not be loaded on first use!";
+    }
+
     QFont font( fontName_);
     font.setPixelSize(size);
     return font;
 }
+
+/// Returns the shared copy of the given options, so icons with the same options share one copy
+QSharedPointer<const QtAwesomeIconOptions> QtAwesome::internOptions( const QtAwesomeIconOptions& options )
+{
+    QSharedPointer<const QtAwesomeIconOptions> interned = internedOptions_.value( options );
+    if( !interned ) {
+        interned = QSharedPointer<const QtAwesomeIconOptions>( new QtAwesomeIconOptions(options) );
+        internedOptions_.insert( options, interned );
+    }
+    return interned;
+}
+
+/// Returns the key under which a pixmap of a font icon is stored in the QPixmapCache
+/// The key contains everything the character painter uses: the text and color for the mode, the scale-factor and the font.
+/// An empty key is returned for animated icons, which mustn't be cached.
+QString QtAwesome::pixmapCacheKey( const QString& text, const QtAwesomeIconOptions& options, const QSize& size, QIcon::Mode mode, QIcon::State state )
+{
+    if( options.anim ) {
+        return QString();
+    }
+
+    return QString("qtawesome:%1:%2:%3x%4:%5:%6:%7:%8")
+            .arg( fontName_ )
+            .arg( options.modeText(mode, text) )
+            .arg( size.width() )
+            .arg( size.height() )
+            .arg( static_cast<int>(mode) )
+            .arg( static_cast<int>(state) )
+            .arg( options.color[mode].rgba(), 8, 16, QChar('0') )
+            .arg( options.scaleFactor );
+}
@@ -16,6 +16,7 @@
 #include <QIconEngine>
 #include <QPainter>
 #include <QRect>
+#include <QSharedPointer>
 #include <QVariantMap>
 
 
@@ -818,6 +819,33 @@ namespace fa {
 
 class QtAwesomeIconPainter;
 
+
+/// The options used to paint a font icon, typed so that painting doesn't look anything up by name.
+/// Identical option sets are interned by QtAwesome, so all the icons using them share one copy.
+/// The QVariantMap options remain the public API, they're converted with fromVariantMap.
+struct QtAwesomeIconOptions
+{
+    enum { ModeCount = QIcon::Selected + 1 };
+
+    QtAwesomeIconOptions();
+
+    QColor color[ModeCount];            ///< The color for each QIcon::Mode
+    QString text[ModeCount];            ///< Replacement text for the other modes, empty to use the icon's own text
+    qreal scaleFactor;                  ///< The glyph size relative to the icon size
+    QtAwesomeAnimation* anim;           ///< The animation, if any (animated icons aren't cached)
+
+    QString modeText( QIcon::Mode mode, const QString& text ) const { return this->text[mode].isEmpty() ? text : this->text[mode]; }
+
+    static QtAwesomeIconOptions fromVariantMap( const QVariantMap& options );
+    bool operator==( const QtAwesomeIconOptions& other ) const;
+};
+
+uint qHash( const QtAwesomeIconOptions& options, uint seed = 0 );
+
+
+//---------------------------------------------------------------------------------------
+
+
 /// The main class for managing icons
 /// This class requires a 2-phase construction. You must first create the class and then initialize it via an init* method
 class QtAwesome : public QObject
@@ -830,10 +858,10 @@ public:
     virtual ~QtAwesome();
 
     void init( const QString& fontname );
-    bool initFontAwesome();
+    bool initFontAwesome( bool lazy = false );
 
     void addNamedCodepoint( const QString& name, int codePoint );
-    QHash<QString,int> namedCodePoints() { return namedCodepoints_; }
+    QHash<QString,int> namedCodePoints();
 
     void setDefaultOption( const QString& name, const QVariant& value  );
     QVariant defaultOption( const QString& name );
@@ -846,16 +874,27 @@ public:
 
     QFont font( int size );
 
+    QSharedPointer<const QtAwesomeIconOptions> internOptions( const QtAwesomeIconOptions& options );
+    QString pixmapCacheKey( const QString& text, const QtAwesomeIconOptions& options, const QSize& size, QIcon::Mode mode, QIcon::State state );
+
     /// Returns the font-name that is used as icon-map
     QString fontName() { return fontName_ ; }
 
+private:
+    bool loadFontAwesome();
+
 private:
     QString fontName_;                                     ///< The font name used for this map
-    QHash<QString,int> namedCodepoints_;                   ///< A map with names mapped to code-points
+    QHash<QString,int> namedCodepoints_;                   ///< Names added with addNamedCodepoint, checked before the font-awesome names
+    bool fontAwesomeNames_;                                ///< Whether the font-awesome names are in use (after initFontAwesome)
+    bool fontAwesomePending_;                              ///< Whether font-awesome still has to be registered (lazy initFontAwesome)
 
     QHash<QString, QtAwesomeIconPainter*> painterMap_;     ///< A map of custom painters
     QVariantMap defaultOptions_;                           ///< The default icon options
     QtAwesomeIconPainter* fontIconPainter_;                ///< A special painter fo painting codepoints
+    QHash<int,QIcon> iconCache_;                           ///< Icons made with the default options, per code-point
+    QHash<QtAwesomeIconOptions, QSharedPointer<const QtAwesomeIconOptions> > internedOptions_; ///< The shared option sets
+    QSharedPointer<const QtAwesomeIconOptions> defaultIconOptions_;   ///< The default options, typed
 };
 
 
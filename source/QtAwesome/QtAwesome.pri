@@ -7,6 +7,25 @@ SOURCES += $$PWD/QtAwesome.cpp \
 HEADERS += $$PWD/QtAwesome.h \   
     $$PWD/QtAwesomeAnim.h
     
-RESOURCES += $$PWD/QtAwesome.qrc
+# CONFIG+=fa_subset embeds a copy of the font holding only the icons the application references
+# (see tools/subset_icon_font.py, which needs fontTools' pyftsubset). The font is subset when qmake
+# runs and again whenever a source file changes.
+fa_subset {
+    FA_SUBSET_DIR = $$OUT_PWD/fa_subset
+    FA_SUBSET_CMD = python3 $$shell_quote($$PWD/../tools/subset_icon_font.py) $$shell_quote($$PWD/..) \
+                    $$shell_quote($$PWD/fonts/fontawesome-4.7.0.ttf) $$shell_quote($$FA_SUBSET_DIR)
+
+    !system($$FA_SUBSET_CMD): error("Failed to subset the icon font")
+
+    fa_subset_font.target = $$FA_SUBSET_DIR/fontawesome-subset.ttf
+    fa_subset_font.commands = $$FA_SUBSET_CMD
+    fa_subset_font.depends = $$files($$PWD/../*.cpp) $$files($$PWD/../*.h)
+    QMAKE_EXTRA_TARGETS += fa_subset_font
+    PRE_TARGETDEPS += $$fa_subset_font.target
+
+    RESOURCES += $$FA_SUBSET_DIR/QtAwesome.qrc
+} else {
+    RESOURCES += $$PWD/QtAwesome.qrc
+}
 
 
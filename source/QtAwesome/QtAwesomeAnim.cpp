@@ -3,44 +3,136 @@
 #include <cmath>
 #include <QPainter>
 #include <QRect>
-#include <QTimer>
 #include <QWidget>
 
 
+QtAwesomeAnimationClock* QtAwesomeAnimationClock::instance()
+{
+    static QtAwesomeAnimationClock clock;
+    return &clock;
+}
+
+QtAwesomeAnimationClock::QtAwesomeAnimationClock()
+{
+    clock_.start();
+    connect( &timer_, SIGNAL(timeout()), this, SLOT(tick()) );
+}
+
+void QtAwesomeAnimationClock::subscribe( QtAwesomeAnimation* animation )
+{
+    if( subscribers_.contains(animation) ) {
+        return;
+    }
+    subscribers_.append( animation );
+    updateInterval();
+}
+
+void QtAwesomeAnimationClock::unsubscribe( QtAwesomeAnimation* animation )
+{
+    if( subscribers_.removeAll(animation) ) {
+        updateInterval();
+    }
+}
+
+void QtAwesomeAnimationClock::tick()
+{
+    // animations that weren't painted since the last tick drop out until they're painted again
+    QList<QtAwesomeAnimation*> subscribers = subscribers_;
+    foreach( QtAwesomeAnimation* animation, subscribers ) {
+        if( !animation->tick() ) {
+            unsubscribe( animation );
+        }
+    }
+}
+
+/// ticks as often as the fastest animation needs, and not at all without any animations
+void QtAwesomeAnimationClock::updateInterval()
+{
+    if( subscribers_.isEmpty() ) {
+        timer_.stop();
+        return;
+    }
+
+    int interval = subscribers_.first()->interval();
+    foreach( QtAwesomeAnimation* animation, subscribers_ ) {
+        interval = qMin( interval, animation->interval() );
+    }
+
+    if( !timer_.isActive() || timer_.interval() != interval ) {
+        timer_.start( interval );
+    }
+}
+
+
+//---------------------------------------------------------------------------------------
+
+
 QtAwesomeAnimation::QtAwesomeAnimation(QWidget *parentWidget, int interval, int step)
     : parentWidgetRef_( parentWidget )
-    , timer_( 0 )
-    , interval_( interval )
+    , interval_( qMax(interval, 1) )
     , step_( step )
-    , angle_( 0.0f )
+    , subscribed_( false )
+    , dirtyAll_( false )
 {
 
 }
 
+QtAwesomeAnimation::~QtAwesomeAnimation()
+{
+    if( subscribed_ ) {
+        QtAwesomeAnimationClock::instance()->unsubscribe( this );
+    }
+}
+
 void QtAwesomeAnimation::setup( QPainter &painter, const QRect &rect)
 {
-    // first time set the timer
-    if( !timer_ )
-    {
-        timer_ = new QTimer();
-        connect(timer_,SIGNAL(timeout()), this, SLOT(update()) );
-        timer_->start(interval_);
+    QtAwesomeAnimationClock* clock = QtAwesomeAnimationClock::instance();
+    if( !subscribed_ ) {
+        clock->subscribe( this );
+        subscribed_ = true;
     }
-    else
-    {
-        //timer, angle, self.step = self.info[self.parent_widget]
-        float x_center = rect.width() * 0.5;
-        float y_center = rect.height() * 0.5;
-        painter.translate(x_center, y_center);
-        painter.rotate(angle_);
-        painter.translate(-x_center, -y_center);
+
+    // remember where the icon went, so only that is repainted on the next tick
+    if( parentWidgetRef_ && painter.device() == parentWidgetRef_.data() ) {
+        dirty_ += painter.deviceTransform().mapRect( rect );
+    } else {
+        dirtyAll_ = true;
     }
+
+    // the angle comes from the shared clock, so every icon with the same animation turns in step
+    float angle = std::fmod( static_cast<double>(step_) * clock->elapsed() / interval_, 360.0 );
+
+    QPointF center = QRectF(rect).center();
+    painter.translate(center);
+    painter.rotate(angle);
+    painter.translate(-center);
 }
 
 
+/// repaints the animated icons in the parent widget
 void QtAwesomeAnimation::update()
 {
-    angle_ += step_;
-    angle_ = std::fmod( angle_, 360);
-    parentWidgetRef_->update();
+    if( !parentWidgetRef_ ) {
+        return;
+    }
+
+    if( dirtyAll_ ) {
+        parentWidgetRef_->update();
+    } else {
+        parentWidgetRef_->update( dirty_ );
+    }
+    dirty_ = QRegion();
+    dirtyAll_ = false;
+}
+
+/// called by the clock, returns false when the animation no longer needs ticks
+bool QtAwesomeAnimation::tick()
+{
+    if( !parentWidgetRef_ || !parentWidgetRef_->isVisible() || (dirty_.isEmpty() && !dirtyAll_) ) {
+        subscribed_ = false;
+        return false;
+    }
+
+    update();
+    return true;
 }
@@ -2,11 +2,46 @@
 #define QTAWESOMEANIMATION_H
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QPointer>
+#include <QRegion>
+#include <QTimer>
 
 class QPainter;
 class QRect;
-class QTimer;
 class QWidget;
+class QtAwesomeAnimation;
+
+///
+/// The clock shared by all of the animated icons, so there's only one timer however many are animating.
+/// Animations subscribe when they're painted and drop out when they stop being painted (e.g. hidden),
+/// and the timer only runs while there's at least one subscriber.
+///
+class QtAwesomeAnimationClock : public QObject
+{
+Q_OBJECT
+
+public:
+    static QtAwesomeAnimationClock* instance();
+
+    void subscribe( QtAwesomeAnimation* animation );
+    void unsubscribe( QtAwesomeAnimation* animation );
+
+    /// milliseconds since the clock was created, all of the animations are driven by this
+    qint64 elapsed() const { return clock_.elapsed(); }
+
+private slots:
+    void tick();
+
+private:
+    QtAwesomeAnimationClock();
+    void updateInterval();
+
+    QTimer timer_;
+    QElapsedTimer clock_;
+    QList<QtAwesomeAnimation*> subscribers_;
+};
 
 ///
 /// Basic Animation Support for QtAwesome (Inspired by https://github.com/spyder-ide/qtawesome)
@@ -17,19 +52,25 @@ Q_OBJECT
 
 public:
     QtAwesomeAnimation( QWidget* parentWidget, int interval=10, int step=1);
+    ~QtAwesomeAnimation();
 
     void setup( QPainter& painter, const QRect& rect );
 
+    int interval() const { return interval_; }
+
 public slots:
     void update();
 
 private:
-    QWidget* parentWidgetRef_;
-    QTimer* timer_;
+    friend class QtAwesomeAnimationClock;
+    bool tick();
+
+    QPointer<QWidget> parentWidgetRef_;
     int interval_;
     int step_;
-    float angle_;
-
+    bool subscribed_;
+    QRegion dirty_;             ///< The icon rects painted since the last tick, in widget coordinates
+    bool dirtyAll_;             ///< Set when an icon was painted somewhere other than the widget (e.g. a pixmap)
 };
 
 
@@ -4,11 +4,12 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui xml concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 include(QtAwesome/QtAwesome.pri)
+include(core.pri)
 
 TARGET = TurboTrainerTimer
 TEMPLATE = app
@@ -18,28 +19,39 @@ SOURCES += main.cpp\
         mainwindow.cpp \
     stepwidget.cpp \
     stagingarea.cpp \
-    turbosetmodel.cpp \
     showtimewidget.cpp \
-    step.cpp \
     nowplayingwidget.cpp \
     stepresources.cpp \
     upnextwidget.cpp \
-    showtimestepwidget.cpp
+    showtimestepwidget.cpp \
+    autosaver.cpp \
+    settreeview.cpp \
+    fontfitcache.cpp \
+    countdownwidget.cpp \
+    startupprofiler.cpp \
+    showtimecanvas.cpp \
+    framescheduler.cpp \
+    progressbars.cpp \
+    timelineview.cpp
 
 HEADERS  += mainwindow.h \
     stepwidget.h \
     stagingarea.h \
-    turbosetmodel.h \
-    types.h \
     showtimewidget.h \
-    step.h \
-    istepmanager.h \
-    isetmanager.h \
     nowplayingwidget.h \
     stepresources.h \
     upnextwidget.h \
     showtimestepwidget.h \
-    ifontawesome.h
+    ifontawesome.h \
+    autosaver.h \
+    settreeview.h \
+    fontfitcache.h \
+    countdownwidget.h \
+    startupprofiler.h \
+    showtimecanvas.h \
+    framescheduler.h \
+    progressbars.h \
+    timelineview.h
 
 FORMS    += mainwindow.ui
 
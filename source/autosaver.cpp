@@ -0,0 +1,121 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "autosaver.h"
+#include "turbosetmodel.h"
+#include <QTimer>
+#include <QFile>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentRun>
+
+static const int DefaultInterval = 5000; // 5 seconds
+
+AutoSaver::AutoSaver(TurboSetModel *model, QObject *parent)
+    : QObject(parent)
+    , m_model(model)
+    , m_timer(nullptr)
+    , m_savedRevision(0)
+    , m_pendingRevision(0)
+    , m_writePending(false)
+{
+    Q_ASSERT(model);
+
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(DefaultInterval);
+
+    QObject::connect(m_timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+    QObject::connect(&m_watcher, SIGNAL(finished()), this, SLOT(onWriteFinished()));
+    QObject::connect(m_model, SIGNAL(setModified()), this, SLOT(onSetModified()));
+}
+
+AutoSaver::~AutoSaver()
+{
+    // Don't leave a half-finished write behind when shutting down.
+    m_watcher.waitForFinished();
+}
+
+void AutoSaver::setPath(const QString &path)
+{
+    m_path = path;
+}
+
+QString AutoSaver::path() const
+{
+    return m_path;
+}
+
+void AutoSaver::setInterval(const int msecs)
+{
+    m_timer->setInterval(msecs);
+}
+
+bool AutoSaver::hasSnapshot() const
+{
+    return !m_path.isEmpty() && QFile::exists(m_path);
+}
+
+void AutoSaver::discard()
+{
+    m_timer->stop();
+    m_writePending = false;
+    m_watcher.waitForFinished();
+
+    // Whatever is in the model now is what the user has chosen to keep (or throw away).
+    m_savedRevision = m_model->revision();
+
+    if (hasSnapshot())
+        QFile::remove(m_path);
+}
+
+bool AutoSaver::writeAtomically(const QString &path, const QByteArray &data)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    // If the write fails the temporary file is discarded when 'file' goes out of scope,
+    // leaving the previous snapshot intact.
+    if (file.write(data) != data.size())
+        return false;
+
+    return file.commit();
+}
+
+void AutoSaver::onSetModified()
+{
+    // Throttle rather than debounce: the first change arms the timer and any further
+    // changes before it fires are picked up by the same snapshot.
+    if (!m_timer->isActive())
+        m_timer->start();
+}
+
+void AutoSaver::onTimeout()
+{
+    if (m_path.isEmpty() || !m_model->dirty() || m_model->revision() == m_savedRevision)
+        return;
+
+    if (m_watcher.isRunning())
+    {
+        m_writePending = true;
+        return;
+    }
+
+    // Building the XML is cheap compared to the disk I/O, and has to happen on this thread
+    // as the model isn't thread-safe. The write itself is handed off to the thread pool.
+    m_pendingRevision = m_model->revision();
+    m_watcher.setFuture(QtConcurrent::run(&AutoSaver::writeAtomically, m_path, m_model->toXml()));
+}
+
+void AutoSaver::onWriteFinished()
+{
+    if (m_watcher.result())
+        m_savedRevision = m_pendingRevision;
+
+    if (m_writePending)
+    {
+        m_writePending = false;
+        m_timer->start();
+    }
+}
@@ -0,0 +1,60 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef AUTOSAVER_H
+#define AUTOSAVER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QFutureWatcher>
+
+class QTimer;
+class TurboSetModel;
+
+/*!
+ * Periodically snapshots the set in the background.
+ * Changes are throttled so that a burst of edits results in a single write, the snapshot is only
+ * taken when the model has changed since the last one, and the file I/O happens on a worker
+ * thread and is atomic (written to a temporary file which is then renamed over the target).
+ */
+class AutoSaver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AutoSaver(TurboSetModel *model, QObject *parent = nullptr);
+    ~AutoSaver();
+
+    //! Set the file the autosave snapshot is written to.
+    void setPath(const QString &path);
+    QString path() const;
+
+    //! Set the minimum time (in milliseconds) between two snapshots.
+    void setInterval(const int msecs);
+
+    //! Query whether a snapshot from a previous session has been left behind (e.g. after a crash).
+    bool hasSnapshot() const;
+
+    //! Remove the snapshot, e.g. once the set has been saved explicitly or intentionally discarded.
+    void discard();
+
+    //! Write data to path, replacing any existing file atomically.
+    static bool writeAtomically(const QString &path, const QByteArray &data);
+
+protected slots:
+    void onSetModified();
+    void onTimeout();
+    void onWriteFinished();
+
+protected:
+    TurboSetModel           *m_model;
+    QTimer                  *m_timer;
+    QFutureWatcher<bool>    m_watcher;
+    QString                 m_path;
+    quint64                 m_savedRevision;
+    quint64                 m_pendingRevision;
+    bool                    m_writePending;
+};
+
+#endif // AUTOSAVER_H
@@ -0,0 +1,330 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "batchprocessor.h"
+#include "turbosetmodel.h"
+#include "workoutimporter.h"
+#include "fitexporter.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+
+/*! Writes a loaded set to a file in a particular format */
+typedef bool (*SetWriter)(TurboSetModel &model, const QString &path, QString &error);
+
+struct OutputFormat
+{
+    const char *name;
+    const char *extension;
+    SetWriter write;
+};
+
+static bool writeTurboSet(TurboSetModel &model, const QString &path, QString &error)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    file.write(model.toXml());
+
+    if (!file.commit())
+    {
+        error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+static bool writeFit(TurboSetModel &model, const QString &path, QString &error)
+{
+    return FitExporter::exportFile(model, path, &error);
+}
+
+static const OutputFormat Formats[] = {
+    { "tttset", "tttset", &writeTurboSet },
+    { "fit", "fit", &writeFit },
+};
+
+static const OutputFormat* findFormat(const QString &name)
+{
+    for (const OutputFormat &format : Formats)
+    {
+        if (name.compare(QLatin1String(format.name), Qt::CaseInsensitive) == 0)
+            return &format;
+    }
+    return nullptr;
+}
+
+static void addIssue(BatchResult &result, const SetIssue::Severity severity, const QString &message, const int line = -1)
+{
+    SetIssue issue;
+    issue.severity = severity;
+    issue.message = message;
+    issue.line = line;
+    result.issues.append(issue);
+}
+
+/*! Functor used to map file paths onto results on the thread pool */
+struct ProcessFile
+{
+    typedef BatchResult result_type;
+
+    explicit ProcessFile(const BatchProcessor *processor)
+        : m_processor(processor)
+    {
+    }
+
+    BatchResult operator()(const QString &path) const
+    {
+        return m_processor->processFile(path);
+    }
+
+    const BatchProcessor *m_processor;
+};
+
+BatchProcessor::BatchProcessor(const BatchOptions &options)
+    : m_options(options)
+{
+}
+
+QList<BatchResult> BatchProcessor::run(const QStringList &files, int jobs /*= 0*/) const
+{
+    if (jobs > 0)
+        QThreadPool::globalInstance()->setMaxThreadCount(jobs);
+
+    return QtConcurrent::blockingMapped<QList<BatchResult> >(files, ProcessFile(this));
+}
+
+BatchResult BatchProcessor::processFile(const QString &path) const
+{
+    BatchResult result;
+    result.path = path;
+    result.name = QFileInfo(path).completeBaseName();
+
+    // Each file gets its own model, living and dying on this worker thread.
+    TurboSetModel model;
+    if (!load(path, model, result))
+        return result;
+
+    result.loaded = true;
+    result.valid = true;
+
+    for (const SetIssue &issue : result.issues)
+    {
+        if (issue.severity == SetIssue::Severity::Error)
+            result.valid = false;
+    }
+
+    if (m_options.validate)
+        result.valid &= SetValidator::validateSteps(model.getIntervals(), result.issues);
+
+    if (m_options.statistics)
+        result.stats = SetValidator::statistics(model.getIntervals());
+
+    if (!m_options.convertTo.isEmpty() && result.valid)
+        convert(model, result);
+
+    if (!m_options.bundle.isEmpty() && result.valid)
+        result.item = SetBundle::makeItem(result.name, model);
+
+    return result;
+}
+
+bool BatchProcessor::writeBundle(const QList<BatchResult> &results, QString *errorMsg /*= nullptr*/) const
+{
+    QList<SetBundle::Item> items;
+    for (const BatchResult &result : results)
+    {
+        if (result.loaded && result.valid)
+            items << result.item;
+    }
+
+    return SetBundle::write(m_options.bundle, items, true, errorMsg);
+}
+
+bool BatchProcessor::load(const QString &path, TurboSetModel &model, BatchResult &result) const
+{
+    QByteArray xml;
+    QString bundlePath;
+    int bundleIndex = -1;
+    QString error;
+
+    if (splitBundlePath(path, bundlePath, bundleIndex))
+    {
+        // Each worker opens the bundle itself and seeks to its own set.
+        SetBundle bundle;
+        if (bundle.open(bundlePath, &error))
+            xml = bundle.readSet(bundleIndex, &error);
+
+        if (xml.isEmpty())
+        {
+            addIssue(result, SetIssue::Severity::Error, error);
+            return false;
+        }
+
+        result.name = bundle.entries().at(bundleIndex).name;
+    }
+    else if (WorkoutImporter::formatForFile(path) != WorkoutImporter::Format::Unknown)
+    {
+        // Workouts from other platforms are converted straight into the model.
+        QStringList warnings;
+        bool imported = WorkoutImporter::importFile(path, model, &error, &warnings);
+
+        for (const QString &warning : warnings)
+        {
+            addIssue(result, SetIssue::Severity::Warning, warning);
+        }
+
+        if (!imported)
+            addIssue(result, SetIssue::Severity::Error, error);
+
+        return imported;
+    }
+    else
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            addIssue(result, SetIssue::Severity::Error, file.errorString());
+            return false;
+        }
+        xml = file.readAll();
+    }
+
+    QDomDocument doc(TurboSetModel::TurboSetTag);
+    int line = 0;
+    if (!doc.setContent(xml, &error, &line))
+    {
+        addIssue(result, SetIssue::Severity::Error, error, line);
+        return false;
+    }
+
+    // Always check the structure, the loader asserts on malformed elements.
+    if (!SetValidator::validateDocument(doc, result.issues))
+        return false;
+
+    model.fromDocument(doc);
+    return true;
+}
+
+bool BatchProcessor::convert(TurboSetModel &model, BatchResult &result) const
+{
+    const OutputFormat *format = findFormat(m_options.convertTo);
+    if (!format)
+    {
+        addIssue(result, SetIssue::Severity::Error, QString("Unknown output format '%1'").arg(m_options.convertTo));
+        result.valid = false;
+        return false;
+    }
+
+    QFileInfo input(result.path);
+    QDir dir(m_options.outputDir.isEmpty() ? input.absolutePath() : m_options.outputDir);
+    QString output = dir.absoluteFilePath(result.name + "." + format->extension);
+
+    if (!m_options.overwrite && QFileInfo::exists(output))
+    {
+        addIssue(result, SetIssue::Severity::Error, QString("%1 already exists").arg(output));
+        result.valid = false;
+        return false;
+    }
+
+    QString error;
+    if (!format->write(model, output, error))
+    {
+        addIssue(result, SetIssue::Severity::Error, QString("Failed to write %1: %2").arg(output, error));
+        result.valid = false;
+        return false;
+    }
+
+    result.output = output;
+    return true;
+}
+
+QStringList BatchProcessor::collectFiles(const QStringList &paths)
+{
+    QStringList filters;
+    for (const QString &ext : inputExtensions())
+    {
+        filters << ("*." + ext);
+    }
+
+    QStringList files;
+    for (const QString &path : paths)
+    {
+        QStringList found;
+        if (QFileInfo(path).isDir())
+        {
+            QDirIterator it(path, filters, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+            {
+                found << it.next();
+            }
+            found.sort();
+        }
+        else
+        {
+            found << path;
+        }
+
+        for (const QString &file : found)
+        {
+            if (QFileInfo(file).suffix().compare(SetBundle::FileExtension, Qt::CaseInsensitive) != 0)
+            {
+                files << file;
+                continue;
+            }
+
+            // Only the index is read here, the sets themselves are read by the workers.
+            SetBundle bundle;
+            if (!bundle.open(file))
+            {
+                files << file; // Let processing report the error
+                continue;
+            }
+
+            for (int i = 0; i < bundle.entries().size(); ++i)
+            {
+                files << QString("%1#%2").arg(file).arg(i);
+            }
+        }
+    }
+    return files;
+}
+
+bool BatchProcessor::splitBundlePath(const QString &path, QString &bundle, int &index)
+{
+    int hash = path.lastIndexOf('#');
+    if (hash < 0)
+        return false;
+
+    bundle = path.left(hash);
+    if (QFileInfo(bundle).suffix().compare(SetBundle::FileExtension, Qt::CaseInsensitive) != 0)
+        return false;
+
+    bool ok = false;
+    index = path.mid(hash + 1).toInt(&ok);
+    return ok;
+}
+
+QStringList BatchProcessor::inputExtensions()
+{
+    return QStringList() << "tttset" << SetBundle::FileExtension << WorkoutImporter::fileExtensions();
+}
+
+QStringList BatchProcessor::outputFormats()
+{
+    QStringList names;
+    for (const OutputFormat &format : Formats)
+    {
+        names << format.name;
+    }
+    return names;
+}
@@ -0,0 +1,94 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include "setvalidator.h"
+#include "setbundle.h"
+
+class TurboSetModel;
+
+/*! What to do with each file in a batch */
+struct BatchOptions
+{
+    BatchOptions()
+        : validate(true)
+        , statistics(false)
+        , overwrite(false)
+    {
+    }
+
+    bool validate;          //!< Check structure and contents of each set.
+    bool statistics;        //!< Gather statistics on each set.
+    bool overwrite;         //!< Allow conversion to replace existing files.
+    QString convertTo;      //!< Name of the output format, or empty to skip conversion.
+    QString outputDir;      //!< Where converted files are written, defaults to alongside the input.
+    QString bundle;         //!< Bundle to pack all valid sets into, or empty to skip.
+};
+
+/*! The outcome of processing a single file */
+struct BatchResult
+{
+    BatchResult()
+        : loaded(false)
+        , valid(false)
+    {
+    }
+
+    QString path;           //!< File path, or "<bundle>#<index>" for a set within a bundle.
+    QString name;           //!< Name of the set, used to name converted files.
+    bool loaded;            //!< The file could be read and parsed.
+    bool valid;             //!< No errors were found.
+    QList<SetIssue> issues;
+    SetStatistics stats;
+    QString output;         //!< Path of the converted file, if any.
+    SetBundle::Item item;   //!< The set, kept when packing into a bundle.
+};
+
+/*! Loads, validates and converts set files, spreading the files across all available cores */
+class BatchProcessor
+{
+public:
+    explicit BatchProcessor(const BatchOptions &options);
+
+    /*!
+     * Process a list of files in parallel.
+     * \param files The files to process.
+     * \param jobs Maximum number of files processed at once, or 0 for one per core.
+     * \return One result per file, in the same order as files.
+     */
+    QList<BatchResult> run(const QStringList &files, int jobs = 0) const;
+
+    //! Process a single file. Safe to call from any thread.
+    BatchResult processFile(const QString &path) const;
+
+    //! Pack every valid set from a batch into the bundle named in the options, appending if it exists.
+    bool writeBundle(const QList<BatchResult> &results, QString *errorMsg = nullptr) const;
+
+    /*!
+     * Expand the given paths into a list of set files, recursing into directories.
+     * Bundles are expanded into one "<bundle>#<index>" entry per set they contain.
+     */
+    static QStringList collectFiles(const QStringList &paths);
+
+    //! The file extensions accepted as input.
+    static QStringList inputExtensions();
+
+    //! The names accepted by BatchOptions::convertTo.
+    static QStringList outputFormats();
+
+protected:
+    bool load(const QString &path, TurboSetModel &model, BatchResult &result) const;
+    static bool splitBundlePath(const QString &path, QString &bundle, int &index);
+    bool convert(TurboSetModel &model, BatchResult &result) const;
+
+protected:
+    BatchOptions m_options;
+};
+
+#endif // BATCHPROCESSOR_H
@@ -0,0 +1,147 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "batchprocessor.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QElapsedTimer>
+
+static QString FormatSeconds(const quint64 seconds)
+{
+    return QString("%1:%2:%3").arg(seconds / 3600, 2, 10, QChar('0'))
+                              .arg((seconds / 60) % 60, 2, 10, QChar('0'))
+                              .arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+static void PrintResult(QTextStream &out, const BatchResult &result, const bool statistics)
+{
+    QString status = !result.loaded ? "FAILED" : (result.valid ? "OK" : "INVALID");
+    out << result.path << ": " << status;
+
+    if (result.loaded && statistics)
+    {
+        out << QString(" (%1 intervals, %2 loops, depth %3, %4 played, %5)")
+               .arg(result.stats.intervals)
+               .arg(result.stats.loops)
+               .arg(result.stats.maxDepth)
+               .arg(result.stats.playedIntervals)
+               .arg(FormatSeconds(result.stats.totalSeconds));
+    }
+
+    if (!result.output.isEmpty())
+        out << " -> " << result.output;
+
+    out << "\n";
+
+    for (const SetIssue &issue : result.issues)
+    {
+        out << "    " << (issue.severity == SetIssue::Severity::Error ? "error" : "warning");
+        if (issue.line >= 0)
+            out << " (line " << issue.line << ")";
+        out << ": " << issue.message << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ttt-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Validates, reports on and converts Turbo Trainer Timer sets in bulk.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("paths", "Set files, or directories to search for set files.", "paths...");
+
+    QCommandLineOption noValidate("no-validate", "Skip checking the contents of each set (structure is always checked).");
+    QCommandLineOption stats(QStringList() << "s" << "stats", "Report statistics for each set, and totals for the batch.");
+    QCommandLineOption convert(QStringList() << "c" << "convert", QString("Convert each valid set to <format> (%1).").arg(BatchProcessor::outputFormats().join(", ")), "format");
+    QCommandLineOption outputDir(QStringList() << "o" << "output-dir", "Write converted sets to <dir> rather than alongside the input.", "dir");
+    QCommandLineOption bundle(QStringList() << "b" << "bundle", "Pack every valid set into <bundle>, appending if it already exists.", "bundle");
+    QCommandLineOption overwrite("overwrite", "Allow converted sets to replace existing files.");
+    QCommandLineOption jobs(QStringList() << "j" << "jobs", "Process at most <n> files at once (default: one per core).", "n");
+    QCommandLineOption quiet(QStringList() << "q" << "quiet", "Only report files with problems.");
+
+    parser.addOption(noValidate);
+    parser.addOption(stats);
+    parser.addOption(convert);
+    parser.addOption(outputDir);
+    parser.addOption(bundle);
+    parser.addOption(overwrite);
+    parser.addOption(jobs);
+    parser.addOption(quiet);
+
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QStringList files = BatchProcessor::collectFiles(parser.positionalArguments());
+    if (files.isEmpty())
+    {
+        err << "No set files given.\n";
+        parser.showHelp(2);
+    }
+
+    BatchOptions options;
+    options.validate = !parser.isSet(noValidate);
+    options.statistics = parser.isSet(stats);
+    options.overwrite = parser.isSet(overwrite);
+    options.convertTo = parser.value(convert);
+    options.outputDir = parser.value(outputDir);
+    options.bundle = parser.value(bundle);
+
+    if (!options.convertTo.isEmpty() && !BatchProcessor::outputFormats().contains(options.convertTo, Qt::CaseInsensitive))
+    {
+        err << "Unknown output format '" << options.convertTo << "'.\n";
+        return 2;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    BatchProcessor processor(options);
+    QList<BatchResult> results = processor.run(files, parser.value(jobs).toInt());
+
+    int failed = 0;
+    SetStatistics totals;
+    for (const BatchResult &result : results)
+    {
+        totals.intervals += result.stats.intervals;
+        totals.loops += result.stats.loops;
+        totals.playedIntervals += result.stats.playedIntervals;
+        totals.totalSeconds += result.stats.totalSeconds;
+
+        bool ok = result.loaded && result.valid;
+        if (!ok)
+            ++failed;
+
+        if (!ok || !result.issues.isEmpty() || !parser.isSet(quiet))
+            PrintResult(out, result, options.statistics);
+    }
+
+    if (!options.bundle.isEmpty())
+    {
+        QString error;
+        if (processor.writeBundle(results, &error))
+            out << "Packed " << (results.size() - failed) << " set(s) into " << options.bundle << "\n";
+        else
+        {
+            err << "Failed to write bundle " << options.bundle << ": " << error << "\n";
+            ++failed;
+        }
+    }
+
+    out << QString("%1 file(s) processed in %2 ms, %3 with errors.\n").arg(results.size()).arg(timer.elapsed()).arg(failed);
+    if (options.statistics)
+    {
+        out << QString("Totals: %1 intervals, %2 loops, %3 played, %4\n")
+               .arg(totals.intervals)
+               .arg(totals.loops)
+               .arg(totals.playedIntervals)
+               .arg(FormatSeconds(totals.totalSeconds));
+    }
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# Headless batch validator/converter for set files
+#
+#-------------------------------------------------
+
+QT       = core xml concurrent
+
+CONFIG  += console c++11
+CONFIG  -= app_bundle
+
+include(../core.pri)
+
+TARGET = ttt-cli
+TEMPLATE = app
+
+
+SOURCES += main.cpp \
+    batchprocessor.cpp
+
+HEADERS += batchprocessor.h
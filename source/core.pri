@@ -0,0 +1,25 @@
+# The set model and everything needed to load, validate and save sets, without any
+# GUI dependencies. Shared by the application and the command-line tool.
+
+QT += xml concurrent
+
+INCLUDEPATH += $$PWD
+
+SOURCES += $$PWD/step.cpp \
+    $$PWD/turbosetmodel.cpp \
+    $$PWD/setvalidator.cpp \
+    $$PWD/setbundle.cpp \
+    $$PWD/lazysetloader.cpp \
+    $$PWD/workoutimporter.cpp \
+    $$PWD/fitexporter.cpp
+
+HEADERS += $$PWD/types.h \
+    $$PWD/step.h \
+    $$PWD/istepmanager.h \
+    $$PWD/isetmanager.h \
+    $$PWD/turbosetmodel.h \
+    $$PWD/setvalidator.h \
+    $$PWD/setbundle.h \
+    $$PWD/lazysetloader.h \
+    $$PWD/workoutimporter.h \
+    $$PWD/fitexporter.h
@@ -0,0 +1,166 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "countdownwidget.h"
+#include "fontfitcache.h"
+#include "framescheduler.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QFontMetrics>
+#include <algorithm>
+
+static const int DigitCount = 10;
+static const QChar Separator(':');
+static const QString WidestText("00:00:00");
+
+CountdownAtlas::CountdownAtlas(const QFont &font, const QColor &colour)
+    : m_font(font)
+    , m_colour(colour)
+    , m_digitWidth(0)
+    , m_separatorWidth(0)
+    , m_cellHeight(0)
+{
+}
+
+void CountdownAtlas::resize(const QSize &size, const qreal pixelRatio)
+{
+    if (size.width() <= 0 || size.height() <= 0)
+    {
+        m_atlas = QPixmap();
+        return;
+    }
+
+    // Fill the height, unless that would make the text too wide.
+    qreal pointSize = std::min(FontFitCache::fitHeight(m_font, size.height()), FontFitCache::fitWidth(m_font, WidestText, size.width()));
+    m_font.setPointSizeF(pointSize);
+
+    // Digits get equal cells, sized for the widest, so the text doesn't jiggle as it counts down.
+    QFontMetrics metrics(m_font);
+    m_digitWidth = 0;
+    for (int i = 0; i < DigitCount; ++i)
+    {
+        m_digitWidth = std::max(m_digitWidth, metrics.width(QChar('0' + i)));
+    }
+    m_separatorWidth = metrics.width(Separator);
+    m_cellHeight = metrics.height();
+
+    QSize atlasSize((m_digitWidth * DigitCount) + m_separatorWidth, m_cellHeight);
+
+    m_atlas = QPixmap(atlasSize * pixelRatio);
+    m_atlas.setDevicePixelRatio(pixelRatio);
+    m_atlas.fill(Qt::transparent);
+
+    QPainter painter(&m_atlas);
+    painter.setFont(m_font);
+    painter.setPen(m_colour);
+
+    for (int i = 0; i <= DigitCount; ++i)
+    {
+        QRect cell = atlasRect(i);
+        painter.drawText(cell, Qt::AlignHCenter | Qt::AlignTop, i < DigitCount ? QString(QChar('0' + i)) : QString(Separator));
+    }
+}
+
+QRect CountdownAtlas::changedRect(const QString &from, const QString &to) const
+{
+    // The text is always the same length, so characters keep their cells.
+    QRect changed;
+    for (int i = 0; i < to.length(); ++i)
+    {
+        if (i >= from.length() || to.at(i) != from.at(i))
+            changed |= cellRect(to, i);
+    }
+    return changed;
+}
+
+void CountdownAtlas::paint(QPainter &painter, const QPoint &origin, const QString &text, const QRect &area) const
+{
+    if (m_atlas.isNull())
+        return;
+
+    qreal ratio = m_atlas.devicePixelRatio();
+
+    for (int i = 0; i < text.length(); ++i)
+    {
+        QRect cell = cellRect(text, i).translated(origin);
+        if (!cell.intersects(area))
+            continue;
+
+        QRect source = atlasRect(glyphIndex(text.at(i)));
+        painter.drawPixmap(QRectF(cell), m_atlas, QRectF(source.x() * ratio, source.y() * ratio, source.width() * ratio, source.height() * ratio));
+    }
+}
+
+QString CountdownAtlas::format(const uint seconds)
+{
+    // Keep to two digits of hours, so the cells never change.
+    uint hours = (seconds / 3600) % 100;
+    uint minutes = (seconds / 60) % 60;
+    uint secs = seconds % 60;
+
+    return QString("%1:%2:%3").arg(hours, 2, 10, QChar('0')).arg(minutes, 2, 10, QChar('0')).arg(secs, 2, 10, QChar('0'));
+}
+
+int CountdownAtlas::glyphIndex(const QChar c) const
+{
+    if (c.isDigit())
+        return c.digitValue();
+
+    Q_ASSERT(c == Separator);
+    return DigitCount;
+}
+
+QRect CountdownAtlas::cellRect(const QString &text, const int pos) const
+{
+    int x = 0;
+    for (int i = 0; i < pos; ++i)
+    {
+        x += (text.at(i) == Separator) ? m_separatorWidth : m_digitWidth;
+    }
+
+    int cellWidth = (text.at(pos) == Separator) ? m_separatorWidth : m_digitWidth;
+    return QRect(x, 0, cellWidth, m_cellHeight);
+}
+
+QRect CountdownAtlas::atlasRect(const int glyph) const
+{
+    if (glyph < DigitCount)
+        return QRect(glyph * m_digitWidth, 0, m_digitWidth, m_cellHeight);
+
+    return QRect(DigitCount * m_digitWidth, 0, m_separatorWidth, m_cellHeight);
+}
+
+
+CountdownWidget::CountdownWidget(const QFont &font, const QColor &colour, QWidget *parent)
+    : QWidget(parent)
+    , m_atlas(font, colour)
+    , m_text(CountdownAtlas::format(0))
+{
+    // Only the glyphs are painted, the parent shows through around them.
+    setAttribute(Qt::WA_NoSystemBackground);
+}
+
+void CountdownWidget::setSecondsRemaining(const uint seconds)
+{
+    QString text = CountdownAtlas::format(seconds);
+    if (text == m_text)
+        return;
+
+    QRect changed = m_atlas.changedRect(m_text, text);
+    m_text = text;
+    FrameScheduler::instance().schedule(this, changed);
+}
+
+void CountdownWidget::resizeEvent(QResizeEvent *event)
+{
+    Q_UNUSED(event);
+    m_atlas.resize(size(), devicePixelRatioF());
+    update();
+}
+
+void CountdownWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    m_atlas.paint(painter, QPoint(0, 0), m_text, event->rect());
+}
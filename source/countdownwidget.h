@@ -0,0 +1,70 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef COUNTDOWNWIDGET_H
+#define COUNTDOWNWIDGET_H
+
+#include <QWidget>
+#include <QFont>
+#include <QColor>
+#include <QPixmap>
+#include <QString>
+
+class QPainter;
+
+/*!
+ * Paints a time remaining as hh:mm:ss in a font scaled to fill a given size.
+ *
+ * The digits and separator are rasterised once per size into an atlas, and each
+ * character is painted by copying its cell from the atlas. Digits have equal cells, so
+ * a change of time only affects the cells whose characters have changed.
+ */
+class CountdownAtlas
+{
+public:
+    CountdownAtlas(const QFont &font, const QColor &colour);
+
+    //! Rebuild the atlas to fill size (in logical pixels) on a screen with the given pixel ratio.
+    void resize(const QSize &size, const qreal pixelRatio);
+
+    //! Get the area, relative to the text's origin, which differs between two times.
+    QRect changedRect(const QString &from, const QString &to) const;
+
+    void paint(QPainter &painter, const QPoint &origin, const QString &text, const QRect &area) const;
+
+    static QString format(const uint seconds);
+
+protected:
+    int glyphIndex(const QChar c) const;
+    QRect cellRect(const QString &text, const int pos) const;
+    QRect atlasRect(const int glyph) const;
+
+protected:
+    QFont       m_font;
+    QColor      m_colour;
+    QPixmap     m_atlas;
+    int         m_digitWidth;
+    int         m_separatorWidth;
+    int         m_cellHeight;
+};
+
+/*! Displays a time remaining, repainting only the digits which change */
+class CountdownWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit CountdownWidget(const QFont &font, const QColor &colour, QWidget *parent = nullptr);
+
+    void setSecondsRemaining(const uint seconds);
+
+protected: // Event handlers
+    void resizeEvent(QResizeEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+
+protected:
+    CountdownAtlas  m_atlas;
+    QString         m_text;
+};
+
+#endif // COUNTDOWNWIDGET_H
@@ -0,0 +1,442 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "fitexporter.h"
+#include "turbosetmodel.h"
+#include "step.h"
+#include <QIODevice>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDateTime>
+
+const QString FitExporter::FileExtension = "fit";
+
+// Protocol and profile versions written to the header.
+static const quint8 ProtocolVersion = 0x20;    // 2.0
+static const quint16 ProfileVersion = 2100;    // 21.00
+static const quint8 HeaderSize = 14;
+
+// Seconds between the Unix epoch and the FIT epoch (1989-12-31 00:00:00 UTC).
+static const quint32 FitEpochOffset = 631065600;
+
+// Global message numbers.
+static const quint16 FileIdMesg = 0;
+static const quint16 WorkoutMesg = 26;
+static const quint16 WorkoutStepMesg = 27;
+
+// Base types.
+static const quint8 FitEnum = 0x00;
+static const quint8 FitString = 0x07;
+static const quint8 FitUInt16 = 0x84;
+static const quint8 FitUInt32 = 0x86;
+
+// Profile values.
+static const quint8 FileTypeWorkout = 5;
+static const quint16 ManufacturerDevelopment = 255;
+static const quint8 SportCycling = 2;
+static const quint8 SubSportIndoorCycling = 6;
+static const quint8 DurationTime = 0;
+static const quint8 DurationOpen = 5;
+static const quint8 DurationRepeatUntilStepsComplete = 6;
+static const quint8 TargetOpen = 2;
+static const quint8 InvalidEnum = 0xFF;
+
+enum class Intensity : quint8
+{
+    Active = 0,
+    Rest = 1,
+    WarmUp = 2,
+    CoolDown = 3,
+    Recovery = 4,
+    Interval = 5
+};
+
+// Fixed sizes for string fields, including the terminator.
+static const int WorkoutNameSize = 32;
+static const int StepNameSize = 16;
+static const int NotesSize = 64;
+
+struct FieldDef
+{
+    quint8 number;
+    quint8 size;
+    quint8 baseType;
+};
+
+struct MesgDef
+{
+    quint8 localType;
+    quint16 globalNumber;
+    const FieldDef *fields;
+    int fieldCount;
+};
+
+static const FieldDef FileIdFields[] = {
+    { 0, 1, FitEnum },                      // type
+    { 1, 2, FitUInt16 },                    // manufacturer
+    { 2, 2, FitUInt16 },                    // product
+    { 4, 4, FitUInt32 },                    // time_created
+};
+
+static const FieldDef WorkoutFields[] = {
+    { 4, 1, FitEnum },                      // sport
+    { 11, 1, FitEnum },                     // sub_sport
+    { 6, 2, FitUInt16 },                    // num_valid_steps
+    { 8, WorkoutNameSize, FitString },      // wkt_name
+};
+
+static const FieldDef WorkoutStepFields[] = {
+    { 254, 2, FitUInt16 },                  // message_index
+    { 0, StepNameSize, FitString },         // wkt_step_name
+    { 1, 1, FitEnum },                      // duration_type
+    { 2, 4, FitUInt32 },                    // duration_value
+    { 3, 1, FitEnum },                      // target_type
+    { 4, 4, FitUInt32 },                    // target_value
+    { 7, 1, FitEnum },                      // intensity
+    { 8, NotesSize, FitString },            // notes
+};
+
+template <size_t N>
+static MesgDef makeDef(const quint8 localType, const quint16 globalNumber, const FieldDef (&fields)[N])
+{
+    MesgDef def = { localType, globalNumber, fields, (int)N };
+    return def;
+}
+
+static const MesgDef FileIdDef = makeDef(0, FileIdMesg, FileIdFields);
+static const MesgDef WorkoutDef = makeDef(1, WorkoutMesg, WorkoutFields);
+static const MesgDef WorkoutStepDef = makeDef(2, WorkoutStepMesg, WorkoutStepFields);
+
+static qint64 definitionSize(const MesgDef &def)
+{
+    return 1 + 5 + (3 * def.fieldCount);   // record header, fixed content, fields
+}
+
+static qint64 dataSize(const MesgDef &def)
+{
+    qint64 size = 1;    // record header
+    for (int i = 0; i < def.fieldCount; ++i)
+    {
+        size += def.fields[i].size;
+    }
+    return size;
+}
+
+/*! Writes little-endian values to a device, keeping a running FIT CRC of everything written */
+class FitStream
+{
+public:
+    explicit FitStream(QIODevice &device)
+        : m_device(device)
+        , m_crc(0)
+        , m_ok(true)
+    {
+    }
+
+    void writeU8(const quint8 value)
+    {
+        writeBytes(reinterpret_cast<const char*>(&value), 1);
+    }
+
+    void writeU16(const quint16 value)
+    {
+        char bytes[2] = { char(value & 0xFF), char((value >> 8) & 0xFF) };
+        writeBytes(bytes, sizeof(bytes));
+    }
+
+    void writeU32(const quint32 value)
+    {
+        char bytes[4] = { char(value & 0xFF), char((value >> 8) & 0xFF), char((value >> 16) & 0xFF), char((value >> 24) & 0xFF) };
+        writeBytes(bytes, sizeof(bytes));
+    }
+
+    //! Write a null-terminated UTF-8 string padded to a fixed size, truncating on a character boundary.
+    void writeString(const QString &text, const int size)
+    {
+        QByteArray utf8 = text.toUtf8();
+        int length = qMin(utf8.size(), size - 1);
+        while (length > 0 && length < utf8.size() && (quint8(utf8.at(length)) & 0xC0) == 0x80)
+        {
+            --length;
+        }
+
+        writeBytes(utf8.constData(), length);
+        for (int i = length; i < size; ++i)
+        {
+            writeU8(0);
+        }
+    }
+
+    void writeDefinition(const MesgDef &def)
+    {
+        writeU8(0x40 | def.localType);
+        writeU8(0);     // reserved
+        writeU8(0);     // little-endian
+        writeU16(def.globalNumber);
+        writeU8(quint8(def.fieldCount));
+        for (int i = 0; i < def.fieldCount; ++i)
+        {
+            writeU8(def.fields[i].number);
+            writeU8(def.fields[i].size);
+            writeU8(def.fields[i].baseType);
+        }
+    }
+
+    void writeDataHeader(const MesgDef &def)
+    {
+        writeU8(def.localType);
+    }
+
+    //! Write the CRC of everything so far. Including it in the CRC brings the CRC back to zero.
+    void writeCrc()
+    {
+        writeU16(m_crc);
+    }
+
+    bool ok() const
+    {
+        return m_ok;
+    }
+
+    QString errorString() const
+    {
+        return m_device.errorString();
+    }
+
+private:
+    void writeBytes(const char *data, const int size)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            updateCrc(quint8(data[i]));
+        }
+
+        if (m_ok && m_device.write(data, size) != size)
+            m_ok = false;
+    }
+
+    void updateCrc(const quint8 byte)
+    {
+        static const quint16 CrcTable[16] = {
+            0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+            0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
+        };
+
+        quint16 tmp = CrcTable[m_crc & 0xF];
+        m_crc = (m_crc >> 4) & 0x0FFF;
+        m_crc = m_crc ^ tmp ^ CrcTable[byte & 0xF];
+
+        tmp = CrcTable[m_crc & 0xF];
+        m_crc = (m_crc >> 4) & 0x0FFF;
+        m_crc = m_crc ^ tmp ^ CrcTable[(byte >> 4) & 0xF];
+    }
+
+private:
+    QIODevice &m_device;
+    quint16 m_crc;
+    bool m_ok;
+};
+
+//! Loops that don't repeat are flattened into their parent, everything else is a step of its own.
+static bool isRepeat(const Step *step)
+{
+    return step->type() == StepType::Loop && static_cast<const LoopStep*>(step)->iterations() > 1;
+}
+
+static quint32 countSteps(const Step *step)
+{
+    if (step->type() != StepType::Loop)
+        return 1;
+
+    quint32 count = 0;
+    for (size_t i = 0; i < step->getChildCount(); ++i)
+    {
+        count += countSteps(step->getChild(i));
+    }
+
+    // An empty loop has nothing to repeat.
+    if (count > 0 && isRepeat(step))
+        ++count;
+
+    return count;
+}
+
+static Intensity intensityForType(const StepType type)
+{
+    switch (type)
+    {
+    case StepType::WarmUp:
+        return Intensity::WarmUp;
+    case StepType::CoolDown:
+        return Intensity::CoolDown;
+    case StepType::Recovery:
+        return Intensity::Recovery;
+    case StepType::Effort:
+        return Intensity::Active;
+    case StepType::Drill:
+    case StepType::Loop:
+        break;
+    }
+    return Intensity::Interval;
+}
+
+static QString nameForType(const StepType type)
+{
+    switch (type)
+    {
+    case StepType::WarmUp:
+        return "Warm up";
+    case StepType::Drill:
+        return "Drill";
+    case StepType::Effort:
+        return "Effort";
+    case StepType::Recovery:
+        return "Recovery";
+    case StepType::CoolDown:
+        return "Cool down";
+    case StepType::Loop:
+        break;
+    }
+    return QString();
+}
+
+static void writeIntervalStep(FitStream &stream, const Interval *interval, const quint16 index)
+{
+    unsigned int duration = interval->duration();
+
+    stream.writeDataHeader(WorkoutStepDef);
+    stream.writeU16(index);
+    stream.writeString(nameForType(interval->type()), StepNameSize);
+    stream.writeU8(duration > 0 ? DurationTime : DurationOpen);   // Zero length waits for the lap button
+    stream.writeU32(duration * 1000);                               // ms
+    stream.writeU8(TargetOpen);
+    stream.writeU32(0);
+    stream.writeU8(quint8(intensityForType(interval->type())));
+    stream.writeString(interval->text(), NotesSize);
+}
+
+static void writeRepeatStep(FitStream &stream, const quint16 index, const quint16 firstChild, const unsigned int iterations)
+{
+    stream.writeDataHeader(WorkoutStepDef);
+    stream.writeU16(index);
+    stream.writeString(QString(), StepNameSize);
+    stream.writeU8(DurationRepeatUntilStepsComplete);
+    stream.writeU32(firstChild);
+    stream.writeU8(InvalidEnum);
+    stream.writeU32(iterations);
+    stream.writeU8(InvalidEnum);
+    stream.writeString(QString(), NotesSize);
+}
+
+static void writeSteps(FitStream &stream, const Step *step, quint16 &index)
+{
+    if (step->type() != StepType::Loop)
+    {
+        writeIntervalStep(stream, static_cast<const Interval*>(step), index++);
+        return;
+    }
+
+    quint16 firstChild = index;
+    for (size_t i = 0; i < step->getChildCount(); ++i)
+    {
+        writeSteps(stream, step->getChild(i), index);
+    }
+
+    if (index != firstChild && isRepeat(step))
+        writeRepeatStep(stream, index++, firstChild, static_cast<const LoopStep*>(step)->iterations());
+}
+
+bool FitExporter::write(const TurboSetModel &model, const QString &name, QIODevice &device, QString *errorMsg /*= nullptr*/)
+{
+    std::vector<Step*> steps = model.getIntervals();
+
+    // First pass: count the steps, which fixes the size of everything that follows.
+    quint32 stepCount = 0;
+    for (const Step *step : steps)
+    {
+        stepCount += countSteps(step);
+    }
+
+    if (stepCount == 0 || stepCount > 0xFFFF)
+    {
+        if (errorMsg)
+            *errorMsg = stepCount == 0 ? "The set has no intervals" : "The set has too many steps for a FIT workout";
+        return false;
+    }
+
+    qint64 recordsSize = definitionSize(FileIdDef) + dataSize(FileIdDef)
+            + definitionSize(WorkoutDef) + dataSize(WorkoutDef)
+            + definitionSize(WorkoutStepDef) + (dataSize(WorkoutStepDef) * stepCount);
+
+    FitStream stream(device);
+    stream.writeU8(HeaderSize);
+    stream.writeU8(ProtocolVersion);
+    stream.writeU16(ProfileVersion);
+    stream.writeU32(quint32(recordsSize));
+    stream.writeU8('.');
+    stream.writeU8('F');
+    stream.writeU8('I');
+    stream.writeU8('T');
+    stream.writeCrc(); // The header's own CRC; the file CRC carries on over it
+
+    // Second pass: stream the records.
+    stream.writeDefinition(FileIdDef);
+    stream.writeDataHeader(FileIdDef);
+    stream.writeU8(FileTypeWorkout);
+    stream.writeU16(ManufacturerDevelopment);
+    stream.writeU16(0);
+    stream.writeU32(quint32(QDateTime::currentDateTimeUtc().toTime_t() - FitEpochOffset));
+
+    stream.writeDefinition(WorkoutDef);
+    stream.writeDataHeader(WorkoutDef);
+    stream.writeU8(SportCycling);
+    stream.writeU8(SubSportIndoorCycling);
+    stream.writeU16(quint16(stepCount));
+    stream.writeString(name, WorkoutNameSize);
+
+    stream.writeDefinition(WorkoutStepDef);
+    quint16 index = 0;
+    for (const Step *step : steps)
+    {
+        writeSteps(stream, step, index);
+    }
+    Q_ASSERT(index == stepCount);
+
+    stream.writeCrc();
+
+    if (!stream.ok())
+    {
+        if (errorMsg)
+            *errorMsg = stream.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool FitExporter::exportFile(const TurboSetModel &model, const QString &path, QString *errorMsg /*= nullptr*/)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        if (errorMsg)
+            *errorMsg = file.errorString();
+        return false;
+    }
+
+    if (!write(model, QFileInfo(path).completeBaseName(), file, errorMsg))
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    if (!file.commit())
+    {
+        if (errorMsg)
+            *errorMsg = file.errorString();
+        return false;
+    }
+
+    return true;
+}
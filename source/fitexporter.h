@@ -0,0 +1,40 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef FITEXPORTER_H
+#define FITEXPORTER_H
+
+#include <QString>
+
+class QIODevice;
+class TurboSetModel;
+
+/*!
+ * Exports a set as a FIT workout file, for loading onto head units and trainer apps.
+ *
+ * The file holds a file_id message, a workout message and one workout_step message per interval.
+ * Loops become repeat steps placed after their children, pointing back at the first child.
+ *
+ * The encoder streams straight to the output device: the step count and data size are worked out
+ * from the set up front, so the header can be written first, and the CRC is updated as bytes go out.
+ */
+class FitExporter
+{
+public:
+    static const QString FileExtension;
+
+    /*!
+     * Encode a set to a device.
+     * \param model The set to export.
+     * \param name The workout name shown on the device (truncated to fit).
+     * \param device An open, writable device.
+     * \param errorMsg Optional, receives a description of the problem on failure.
+     */
+    static bool write(const TurboSetModel &model, const QString &name, QIODevice &device, QString *errorMsg = nullptr);
+
+    //! Encode a set to a file, named after the file. The file is only replaced once fully written.
+    static bool exportFile(const TurboSetModel &model, const QString &path, QString *errorMsg = nullptr);
+};
+
+#endif // FITEXPORTER_H
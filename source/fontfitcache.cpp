@@ -0,0 +1,113 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "fontfitcache.h"
+#include <QFontMetricsF>
+#include <QGuiApplication>
+#include <QScreen>
+#include <algorithm>
+
+static const qreal ReferenceSize = 100.0;   // Large enough that rounding in the metrics doesn't matter
+static const qreal MinimumSize = 1.0;
+static const int MaxEntries = 512;          // Every size passed through while dragging a window edge ends up here
+static const int MaxCorrections = 4;
+
+qreal FontFitCache::fitHeight(const QFont &font, const int height)
+{
+    QString key = QString("%1|h|%2").arg(styleKey(font)).arg(height);
+
+    FontFitCache &cache = instance();
+    auto it = cache.m_sizes.constFind(key);
+    if (it != cache.m_sizes.constEnd())
+        return it.value();
+
+    qreal size = fit(font, height, [](const QFontMetricsF &metrics)
+    {
+        return metrics.height();
+    });
+
+    if (cache.m_sizes.size() >= MaxEntries)
+        cache.m_sizes.clear();
+    cache.m_sizes.insert(key, size);
+    return size;
+}
+
+qreal FontFitCache::fitWidth(const QFont &font, const QString &text, const int width)
+{
+    QString pattern = textPattern(text);
+    QString key = QString("%1|w|%2|%3").arg(styleKey(font)).arg(width).arg(pattern);
+
+    FontFitCache &cache = instance();
+    auto it = cache.m_sizes.constFind(key);
+    if (it != cache.m_sizes.constEnd())
+        return it.value();
+
+    qreal size = fit(font, width, [&pattern](const QFontMetricsF &metrics)
+    {
+        return metrics.width(pattern);
+    });
+
+    if (cache.m_sizes.size() >= MaxEntries)
+        cache.m_sizes.clear();
+    cache.m_sizes.insert(key, size);
+    return size;
+}
+
+QString FontFitCache::styleKey(const QFont &font)
+{
+    // Metrics without a paint device are taken at the primary screen's DPI, which can change
+    // (e.g. when moving between displays), so sizes fitted at another DPI aren't reused.
+    QScreen *screen = QGuiApplication::primaryScreen();
+    qreal dpi = screen ? screen->logicalDotsPerInchY() : 0;
+
+    return QString("%1|%2|%3|%4|%5").arg(font.family()).arg(font.weight()).arg(font.italic()).arg(font.stretch()).arg(dpi);
+}
+
+QString FontFitCache::textPattern(const QString &text)
+{
+    // Digits are close enough to the same width (and exactly so in tabular fonts) to share a pattern.
+    QString pattern(text);
+    for (QChar &c : pattern)
+    {
+        if (c.isDigit())
+            c = QLatin1Char('0');
+    }
+    return pattern;
+}
+
+template <typename Measure>
+qreal FontFitCache::fit(const QFont &font, const int target, Measure measure)
+{
+    if (target <= 0)
+        return MinimumSize;
+
+    QFont scaled(font);
+    scaled.setPointSizeF(ReferenceSize);
+
+    qreal extent = measure(QFontMetricsF(scaled));
+    if (extent <= 0)
+        return MinimumSize;
+
+    // Metrics scale (almost) linearly with the point size, so one measurement gets the answer...
+    qreal size = std::max(ReferenceSize * target / extent, MinimumSize);
+
+    // ...give or take hinting, which is corrected for by nudging the size down until it fits.
+    for (int i = 0; i < MaxCorrections && size > MinimumSize; ++i)
+    {
+        scaled.setPointSizeF(size);
+        extent = measure(QFontMetricsF(scaled));
+        if (extent <= target)
+            break;
+
+        size = std::max(size * target / extent - 0.25, MinimumSize);
+    }
+
+    return size;
+}
+
+FontFitCache& FontFitCache::instance()
+{
+    static FontFitCache cache;
+    return cache;
+}
@@ -0,0 +1,42 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef FONTFITCACHE_H
+#define FONTFITCACHE_H
+
+#include <QFont>
+#include <QHash>
+#include <QString>
+
+/*!
+ * Works out the point size at which text in a given font fills a given height or width.
+ *
+ * The size is computed exactly, from the metrics of the font at a reference size, and
+ * remembered against the font's family and style, the DPI it was measured at, the target
+ * dimension and (when fitting the width) a pattern of the text. Digits all share a pattern, so a countdown
+ * only has its metrics measured once however many times its value changes.
+ */
+class FontFitCache
+{
+public:
+    //! Get the point size at which the font's line height is no more than height pixels.
+    static qreal fitHeight(const QFont &font, const int height);
+
+    //! Get the point size at which the text is no wider than width pixels.
+    static qreal fitWidth(const QFont &font, const QString &text, const int width);
+
+protected:
+    static QString styleKey(const QFont &font);
+    static QString textPattern(const QString &text);
+
+    template <typename Measure>
+    static qreal fit(const QFont &font, const int target, Measure measure);
+
+    static FontFitCache& instance();
+
+protected:
+    QHash<QString, qreal> m_sizes;
+};
+
+#endif // FONTFITCACHE_H
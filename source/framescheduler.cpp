@@ -0,0 +1,98 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "framescheduler.h"
+#include <QWidget>
+#include <QGuiApplication>
+#include <QScreen>
+#include <algorithm>
+
+static const qreal DefaultRefreshRate = 60.0;
+
+FrameScheduler::FrameScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&m_timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+FrameScheduler& FrameScheduler::instance()
+{
+    static FrameScheduler scheduler;
+    return scheduler;
+}
+
+void FrameScheduler::schedule(QWidget *widget)
+{
+    if (!widget)
+    {
+        Q_ASSERT(false);
+        return;
+    }
+
+    schedule(widget, widget->rect());
+}
+
+void FrameScheduler::schedule(QWidget *widget, const QRect &rect)
+{
+    if (!widget)
+    {
+        Q_ASSERT(false);
+        return;
+    }
+
+    if (rect.isEmpty())
+        return;
+
+    auto it = m_dirty.find(widget);
+    if (it == m_dirty.end())
+    {
+        m_dirty.insert(widget, QRegion(rect));
+        QObject::connect(widget, SIGNAL(destroyed(QObject*)), this, SLOT(onWidgetDestroyed(QObject*)), Qt::UniqueConnection);
+    }
+    else
+    {
+        *it += rect;
+    }
+
+    if (m_timer.isActive())
+        return;
+
+    // Flush on the next frame: straight away if the last flush was at least a frame ago.
+    int interval = frameInterval();
+    qint64 sinceLast = m_lastFlush.isValid() ? m_lastFlush.elapsed() : interval;
+    m_timer.start((int)std::max<qint64>(interval - sinceLast, 0));
+}
+
+void FrameScheduler::flush()
+{
+    m_lastFlush.start();
+
+    // Widgets may schedule more while being updated, those go in the next frame.
+    QHash<QWidget*, QRegion> dirty;
+    dirty.swap(m_dirty);
+
+    for (auto it = dirty.constBegin(); it != dirty.constEnd(); ++it)
+    {
+        QObject::disconnect(it.key(), SIGNAL(destroyed(QObject*)), this, SLOT(onWidgetDestroyed(QObject*)));
+        it.key()->update(it.value());
+    }
+}
+
+void FrameScheduler::onWidgetDestroyed(QObject *widget)
+{
+    // Only the address is used, the widget is already partly destroyed.
+    m_dirty.remove(static_cast<QWidget*>(widget));
+}
+
+int FrameScheduler::frameInterval() const
+{
+    QScreen *screen = QGuiApplication::primaryScreen();
+    qreal rate = screen ? screen->refreshRate() : DefaultRefreshRate;
+    if (rate <= 0)
+        rate = DefaultRefreshRate;
+
+    return std::max(qRound(1000.0 / rate), 1);
+}
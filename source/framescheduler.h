@@ -0,0 +1,51 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+#include <QRegion>
+#include <QTimer>
+#include <QElapsedTimer>
+
+class QWidget;
+
+/*!
+ * Collects the areas of widgets which need repainting and flushes them at most once
+ * per display frame.
+ *
+ * Several changes in quick succession (e.g. everything that changes at the start of an
+ * interval) are merged into a single update, and the screen is never asked to repaint
+ * faster than it refreshes. Nothing runs while nothing is dirty.
+ */
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static FrameScheduler& instance();
+
+    //! Mark the whole widget as needing a repaint.
+    void schedule(QWidget *widget);
+
+    //! Mark an area of the widget (in its own coordinates) as needing a repaint.
+    void schedule(QWidget *widget, const QRect &rect);
+
+protected slots:
+    void flush();
+    void onWidgetDestroyed(QObject *widget);
+
+protected:
+    explicit FrameScheduler(QObject *parent = nullptr);
+
+    int frameInterval() const;
+
+protected:
+    QHash<QWidget*, QRegion> m_dirty;
+    QTimer m_timer;
+    QElapsedTimer m_lastFlush;
+};
+
+#endif // FRAMESCHEDULER_H
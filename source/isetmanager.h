@@ -9,6 +9,15 @@
 
 class Interval;
 
+/*! How far playback has got through the current interval and the whole set, in milliseconds */
+struct PlaybackProgress
+{
+    int64_t intervalElapsed;
+    int64_t intervalDuration;
+    int64_t setElapsed;
+    int64_t setDuration;
+};
+
 /*! An interface for querying information regarding the currently-running set. */
 class ISetManager
 {
@@ -27,6 +36,13 @@ public:
      * \return true if we are currently in a loop during playback, false otherwise.
      */
     virtual bool currentIteration(uint32_t &current, uint32_t &total) = 0;
+
+    /*!
+     * \brief Query how far playback has got, read from the playback clock itself.
+     * \param progress Receives the elapsed and total times.
+     * \return true if a set is playing or paused, false otherwise.
+     */
+    virtual bool playbackProgress(PlaybackProgress &progress) = 0;
 };
 
 #endif // ISETMANAGER_H
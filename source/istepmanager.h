@@ -5,6 +5,10 @@
 #ifndef ISTEPMANAGER_H
 #define ISTEPMANAGER_H
 
+#include <cstddef>
+
+class Step;
+
 /*! An interfact for alerting the step model that a change has been made */
 class IStepManager
 {
@@ -13,6 +17,26 @@ public:
      * \param redrawNeeded Whether or not the change should result in a redraw.
      */
     virtual void notifyChange(bool redrawNeeded = false) = 0;
+
+    /*! Structural changes, so views can update just the affected steps.
+     * \param parent The loop whose children changed, nullptr for the top level of the set.
+     */
+    virtual void notifyAboutToInsert(Step *parent, size_t index) = 0;
+    virtual void notifyInserted(Step *parent, size_t index) = 0;
+    virtual void notifyAboutToRemove(Step *parent, size_t index) = 0;
+    virtual void notifyRemoved(Step *parent, size_t index) = 0;
+    virtual void notifyAboutToMove(Step *parent, size_t from, size_t to) = 0;
+    virtual void notifyMoved(Step *parent, size_t from, size_t to) = 0;
+
+    //! A lazily-loaded loop is about to create its children, and has created them.
+    virtual void notifyAboutToMaterialise(Step *loop, size_t childCount) = 0;
+    virtual void notifyMaterialised(Step *loop) = 0;
+
+    //! Notify the model that a value of a step (duration, text, iterations) has been edited.
+    virtual void notifyDataChanged(Step *step) = 0;
+
+    //! Notify the model that a step changed in a way its view can't know about (e.g. its type).
+    virtual void notifyUpdated(Step *step) = 0;
 };
 
 #endif // ISTEPMANAGER_H
@@ -0,0 +1,200 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "lazysetloader.h"
+#include "step.h"
+#include "turbosetmodel.h"
+#include <QXmlStreamReader>
+#include <algorithm>
+
+/*!
+ * Converts the character offsets reported by QXmlStreamReader into byte offsets within the
+ * UTF-8 source. Offsets must be requested in increasing order, which keeps the total cost
+ * linear in the size of the source.
+ */
+class Utf8OffsetMapper
+{
+public:
+    Utf8OffsetMapper(const char *data, const qint64 size)
+        : m_data(data)
+        , m_size(size)
+        , m_char(0)
+        , m_byte(0)
+    {
+        // The byte-order mark isn't counted as a character by the reader.
+        if (size >= 3 && (uchar)data[0] == 0xef && (uchar)data[1] == 0xbb && (uchar)data[2] == 0xbf)
+            m_byte = 3;
+    }
+
+    qint64 toByte(const qint64 charOffset)
+    {
+        Q_ASSERT(charOffset >= m_char);
+
+        while (m_char < charOffset && m_byte < m_size)
+        {
+            uchar lead = (uchar)m_data[m_byte];
+            if (lead < 0x80)
+            {
+                m_byte += 1;
+                m_char += 1;
+            }
+            else if ((lead & 0xe0) == 0xc0)
+            {
+                m_byte += 2;
+                m_char += 1;
+            }
+            else if ((lead & 0xf0) == 0xe0)
+            {
+                m_byte += 3;
+                m_char += 1;
+            }
+            else if ((lead & 0xf8) == 0xf0)
+            {
+                m_byte += 4;
+                m_char += 2; // Outside the BMP, so a surrogate pair in UTF-16
+            }
+            else
+            {
+                m_byte += 1; // Invalid lead byte, decoded as a replacement character
+                m_char += 1;
+            }
+        }
+
+        return std::min(m_byte, m_size);
+    }
+
+protected:
+    const char *m_data;
+    qint64 m_size;
+    qint64 m_char;
+    qint64 m_byte;
+};
+
+bool LazySetLoader::loadSet(const LazySetSourcePtr &source, IStepManager *manager, std::vector<Step*> &steps)
+{
+    const QByteArray &data = source->data();
+    QXmlStreamReader reader(data);
+    Utf8OffsetMapper mapper(data.constData(), data.size());
+
+    if (!reader.readNextStartElement() || reader.name() != TurboSetModel::TurboSetTag)
+        return false;
+
+    return readChildren(reader, mapper, 0, source, manager, steps);
+}
+
+bool LazySetLoader::loadLoopBody(const LazySetSourcePtr &source, const qint64 begin, const qint64 end,
+                                 IStepManager *manager, std::vector<Step*> &children)
+{
+    QByteArray fragment = source->slice(begin, end);
+    QXmlStreamReader reader(fragment);
+    Utf8OffsetMapper mapper(fragment.constData(), fragment.size());
+
+    // Step into the <loop> element itself, its children are then read as usual.
+    if (!reader.readNextStartElement())
+        return false;
+
+    return readChildren(reader, mapper, begin, source, manager, children);
+}
+
+bool LazySetLoader::readChildren(QXmlStreamReader &reader, Utf8OffsetMapper &mapper, const qint64 base,
+                                 const LazySetSourcePtr &source, IStepManager *manager, std::vector<Step*> &steps)
+{
+    const QByteArray &data = source->data();
+
+    while (!reader.atEnd())
+    {
+        // The offset before reading a token is where that token starts.
+        qint64 tokenStart = reader.characterOffset();
+        QXmlStreamReader::TokenType token = reader.readNext();
+
+        if (token == QXmlStreamReader::EndElement || token == QXmlStreamReader::EndDocument)
+            break;
+
+        if (token != QXmlStreamReader::StartElement)
+            continue;
+
+        if (reader.name().compare(TurboSetModel::IntervalTag, Qt::CaseInsensitive) == 0)
+        {
+            Interval *interval = Interval::fromXml(reader, manager);
+            if (interval)
+                steps.push_back(interval);
+        }
+        else if (reader.name().compare(TurboSetModel::LoopTag, Qt::CaseInsensitive) == 0)
+        {
+            QXmlStreamAttributes attributes = reader.attributes();
+            if (!attributes.hasAttribute(TurboSetModel::IterationsAttr))
+            {
+                reader.skipCurrentElement();
+                continue;
+            }
+
+            size_t children = 0;
+            unsigned int duration = 0;
+            quint64 playedDuration = 0;
+            skimLoopBody(reader, children, duration, playedDuration);
+
+            if (reader.hasError())
+                break;
+
+            qint64 begin = base + mapper.toByte(tokenStart);
+            qint64 end = base + mapper.toByte(reader.characterOffset());
+
+            // If the range doesn't look like an element the offsets can't be trusted (e.g. the source
+            // isn't UTF-8), so give up and let the caller load the set eagerly.
+            if (end <= begin || end > data.size() || data.at(begin) != '<' || data.at(end - 1) != '>')
+                return false;
+
+            LoopStep *loop = new LoopStep(manager);
+            loop->setLazyBody(source, begin, end, attributes.value(TurboSetModel::IterationsAttr).toUInt(), children, duration, playedDuration);
+            steps.push_back(loop);
+        }
+        else
+        {
+            reader.skipCurrentElement();
+        }
+    }
+
+    return !reader.hasError();
+}
+
+void LazySetLoader::skimLoopBody(QXmlStreamReader &reader, size_t &children, unsigned int &duration, quint64 &playedDuration)
+{
+    // Count the children that would survive a full load and add up their durations, without creating anything.
+    // The played duration also counts the iterations of nested loops, the duration (as LoopStep::duration()) doesn't.
+    while (reader.readNextStartElement())
+    {
+        QXmlStreamAttributes attributes = reader.attributes();
+
+        if (reader.name().compare(TurboSetModel::IntervalTag, Qt::CaseInsensitive) == 0)
+        {
+            if (attributes.hasAttribute(TurboSetModel::TypeAttr)
+                    && attributes.hasAttribute(TurboSetModel::DurationAttr)
+                    && attributes.hasAttribute(TurboSetModel::TextAttr))
+            {
+                unsigned int seconds = attributes.value(TurboSetModel::DurationAttr).toUInt();
+                ++children;
+                duration += seconds;
+                playedDuration += seconds;
+            }
+            reader.skipCurrentElement();
+        }
+        else if (reader.name().compare(TurboSetModel::LoopTag, Qt::CaseInsensitive) == 0
+                 && attributes.hasAttribute(TurboSetModel::IterationsAttr))
+        {
+            size_t nestedChildren = 0;
+            unsigned int nestedDuration = 0;
+            quint64 nestedPlayedDuration = 0;
+            unsigned int iterations = attributes.value(TurboSetModel::IterationsAttr).toUInt();
+            skimLoopBody(reader, nestedChildren, nestedDuration, nestedPlayedDuration);
+
+            ++children;
+            duration += nestedDuration;
+            playedDuration += nestedPlayedDuration * LoopStep::playedIterations(iterations);
+        }
+        else
+        {
+            reader.skipCurrentElement();
+        }
+    }
+}
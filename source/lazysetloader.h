@@ -0,0 +1,82 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef LAZYSETLOADER_H
+#define LAZYSETLOADER_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <vector>
+
+class Step;
+class LoopStep;
+class IStepManager;
+class QXmlStreamReader;
+class Utf8OffsetMapper;
+
+/*! The raw content of a set file, kept so that loop bodies can be parsed on demand */
+class LazySetSource
+{
+public:
+    explicit LazySetSource(const QByteArray &data)
+        : m_data(data)
+    {
+    }
+
+    const QByteArray& data() const
+    {
+        return m_data;
+    }
+
+    //! Get the raw bytes of the range [begin, end) without copying them.
+    QByteArray slice(const qint64 begin, const qint64 end) const
+    {
+        Q_ASSERT(begin >= 0 && begin <= end && end <= m_data.size());
+        return QByteArray::fromRawData(m_data.constData() + begin, (int)(end - begin));
+    }
+
+protected:
+    QByteArray m_data;
+};
+
+typedef QSharedPointer<const LazySetSource> LazySetSourcePtr;
+
+/*!
+ * Loads sets without instantiating the contents of loops.
+ *
+ * Each <loop> element is skimmed for its child count and duration, then recorded as a byte range
+ * in the source. The loop's children are only parsed into Step objects when something asks for
+ * them (see LoopStep::materialise()), at which point any nested loops are deferred in the same way.
+ */
+class LazySetLoader
+{
+public:
+    /*!
+     * Load the top level of a set.
+     * \param source The content of the set file.
+     * \param manager The manager to assign to created steps.
+     * \param steps Receives the top-level steps.
+     * \return false if the content could not be parsed or the byte ranges could not be determined reliably,
+     *         in which case the set should be loaded eagerly instead.
+     */
+    static bool loadSet(const LazySetSourcePtr &source, IStepManager *manager, std::vector<Step*> &steps);
+
+    /*!
+     * Load the direct children of a loop recorded by loadSet() or a previous loadLoopBody().
+     * \param source The content of the set file.
+     * \param begin Byte offset of the loop's start tag.
+     * \param end Byte offset just past the loop's end tag.
+     * \param manager The manager to assign to created steps.
+     * \param children Receives the loop's children.
+     */
+    static bool loadLoopBody(const LazySetSourcePtr &source, const qint64 begin, const qint64 end,
+                             IStepManager *manager, std::vector<Step*> &children);
+
+protected:
+    static bool readChildren(QXmlStreamReader &reader, Utf8OffsetMapper &mapper, const qint64 base,
+                             const LazySetSourcePtr &source, IStepManager *manager, std::vector<Step*> &steps);
+    static void skimLoopBody(QXmlStreamReader &reader, size_t &children, unsigned int &duration, quint64 &playedDuration);
+};
+
+#endif // LAZYSETLOADER_H
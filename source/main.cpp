@@ -3,13 +3,22 @@
  *************************************/
 
 #include "mainwindow.h"
+#include "startupprofiler.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    StartupProfiler &profiler = StartupProfiler::instance();
+    profiler.start();
+
     QApplication a(argc, argv);
+    profiler.setEnabled(a.arguments().contains("--profile-startup"));
+    profiler.mark("Application");
+
     MainWindow w;
+    profiler.watchFirstPaint(&w);
     w.show();
+    profiler.mark("Show");
 
     return a.exec();
 }
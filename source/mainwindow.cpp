@@ -7,14 +7,29 @@
 
 #include "stepwidget.h"
 #include "stepresources.h"
+#include "setbundle.h"
+#include "fitexporter.h"
+#include "startupprofiler.h"
 
 #include <QMenu>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QScrollBar>
+#include <QStatusBar>
+#include <QDockWidget>
 #include <QCloseEvent>
 #include <QSettings>
 #include <QTimer>
+#include <QStandardPaths>
+#include <QDir>
+#include <QInputDialog>
+#include <QFileInfo>
+#include <QTime>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWindow>
+#include <QtConcurrent/QtConcurrentRun>
 
 #ifdef Q_OS_WIN
 #include <Windows.h>
@@ -22,29 +37,43 @@
 
 static const QString AppRegKey = "TurboTrainerTimer";
 static const QString FileFilter = "Turbo Trainer Timer Set (*.tttset)";
+static const QString BundleFilter = "Turbo Trainer Timer Bundle (*.tttbundle)";
+static const QString WorkoutFilter = "Workouts (*.erg *.mrc *.zwo)";
+static const QString FitFilter = "FIT Workout (*.fit)";
+static const QString AutoSaveFile = "autosave.tttset";
+static const qint64 LazyLoadThreshold = 256 * 1024; // Sets larger than this (in bytes) load their loops on demand
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , m_scrollArea(nullptr)
     , m_stagingArea(nullptr)
+    , m_treeDock(nullptr)
+    , m_treeView(nullptr)
+    , m_timelineDock(nullptr)
+    , m_timeline(nullptr)
     , m_showtimeWindow(nullptr)
     , m_showtimeWidget(nullptr)
+    , m_mirrorAction(nullptr)
+    , m_autoSaver(nullptr)
+    , m_importWatcher(nullptr)
     , m_fontAwesome(nullptr)
     , m_scrollPos(0)
     , m_fullScreen(false)
 {
+    StartupProfiler &profiler = StartupProfiler::instance();
 
     m_fontAwesome = new QtAwesome(this);
-    if (!m_fontAwesome->initFontAwesome())
+    if (!m_fontAwesome->initFontAwesome(true)) // Registered when the first icon is drawn
     {
         Q_ASSERT(false);
     }
+    profiler.mark("Icon font");
 
+    // The show-time screen isn't needed until a set is played, so it's created then.
     m_scrollArea = new QScrollArea(this);
     m_stagingArea = new StagingArea(&m_setModel, this, this);
-    m_showtimeWidget = new ShowTimeWidget(&m_setModel, this, this);
-    m_showtimeWidget->hide();
+    profiler.mark("Staging area");
 
     ui->setupUi(this);
     setCentralWidget(m_scrollArea);
@@ -64,35 +93,68 @@ MainWindow::MainWindow(QWidget *parent)
     ui->actionPlay->setEnabled(false);
     ui->actionPause->setEnabled(false);
     ui->actionStop->setEnabled(false);
+    profiler.mark("Menus and toolbar");
+
+    // Outline of the set as a tree, an alternative to the staging area for large sets
+    m_treeView = new SetTreeView(&m_setModel, this, this);
+    m_treeDock = new QDockWidget("Set Outline", this);
+    m_treeDock->setObjectName("treeDock");
+    m_treeDock->setWidget(m_treeView);
+    addDockWidget(Qt::LeftDockWidgetArea, m_treeDock);
+    m_treeDock->hide();
+    ui->menuView->addAction(m_treeDock->toggleViewAction());
+    profiler.mark("Set outline");
+
+    m_timeline = new TimelineView(&m_setModel, this);
+    m_timelineDock = new QDockWidget("Set Timeline", this);
+    m_timelineDock->setObjectName("timelineDock");
+    m_timelineDock->setWidget(m_timeline);
+    addDockWidget(Qt::BottomDockWidgetArea, m_timelineDock);
+    m_timelineDock->hide();
+    ui->menuView->addAction(m_timelineDock->toggleViewAction());
+    QObject::connect(m_timeline, SIGNAL(stepClicked(Step*)), this, SLOT(onTimelineStepClicked(Step*)));
+    profiler.mark("Set timeline");
+
+    // Extra screens (e.g. side and instructor screens) can mirror the show-time screen.
+    m_mirrorAction = ui->menuView->addAction("Mirror Show-Time to Other Screens");
+    m_mirrorAction->setCheckable(true);
+    QObject::connect(m_mirrorAction, SIGNAL(toggled(bool)), this, SLOT(onMirrorToggled(bool)));
+    QObject::connect(qApp, SIGNAL(screenAdded(QScreen*)), this, SLOT(updateMirrors()));
+    QObject::connect(qApp, SIGNAL(screenRemoved(QScreen*)), this, SLOT(updateMirrors()));
 
     QObject::connect(&m_setModel, SIGNAL(setChanged()), this, SLOT(onSetChanged()));
+    QObject::connect(&m_setModel, SIGNAL(stepInserted(Step*,int)), this, SLOT(onSetChanged()));
+    QObject::connect(&m_setModel, SIGNAL(stepRemoved(Step*,int)), this, SLOT(onSetChanged()));
     QObject::connect(&m_setModel, SIGNAL(setChanged()), m_stagingArea, SLOT(onSetChanged()));
     QObject::connect(m_stagingArea, SIGNAL(sizeChanged()), this, SLOT(onStagingAreaResized()));
-    QObject::connect(&m_setModel, SIGNAL(intervalStarted()), m_showtimeWidget, SLOT(onIntervalStarted()));
-    QObject::connect(&m_setModel, SIGNAL(setStarted()), m_showtimeWidget, SLOT(onSetStarted()));
-    QObject::connect(&m_setModel, SIGNAL(setPaused()), m_showtimeWidget, SLOT(onSetPaused()));
-    QObject::connect(&m_setModel, SIGNAL(setResumed()), m_showtimeWidget, SLOT(onSetResumed()));
-    QObject::connect(&m_setModel, SIGNAL(setComplete()), m_showtimeWidget, SLOT(onSetComplete()));
-    QObject::connect(&m_setModel, SIGNAL(setStopped()), m_showtimeWidget, SLOT(onSetStopped()));
     QObject::connect(&m_setModel, SIGNAL(setStarted()), this, SLOT(onSetStarted()));
     QObject::connect(&m_setModel, SIGNAL(setPaused()), this, SLOT(onSetPaused()));
     QObject::connect(&m_setModel, SIGNAL(setResumed()), this, SLOT(onSetResumed()));
     QObject::connect(&m_setModel, SIGNAL(setComplete()), this, SLOT(onSetComplete()));
     QObject::connect(&m_setModel, SIGNAL(setStopped()), this, SLOT(onSetStopped()));
-    QObject::connect(&m_setModel, SIGNAL(playbackError(QString)), m_showtimeWidget, SLOT(onPlaybackError(QString)));
     QObject::connect(m_scrollArea->verticalScrollBar(), SIGNAL(sliderMoved(int)), this, SLOT(onSliderMoved(int)));
-    QObject::connect(m_showtimeWidget, SIGNAL(toggleFullscreen()), this, SLOT(onToggleFullscreen()));
-    QObject::connect(m_showtimeWidget, SIGNAL(closeFullScreen()), this, SLOT(onCloseFullscreen()));
-    QObject::connect(m_showtimeWidget, SIGNAL(playPauseToggle()), this, SLOT(onPlayPauseToggle()));
 
     // Restore position/state from previous session
     QSettings settings(AppRegKey);
     restoreGeometry(settings.value("geometry").toByteArray());
     restoreState(settings.value("windowState").toByteArray());
+    m_mirrorAction->setChecked(settings.value("mirrorShowTime", false).toBool());
+    profiler.mark("Settings");
+
+    // Keep a background snapshot of unsaved work, and offer it back if the last session didn't exit cleanly.
+    QString autoSaveDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(autoSaveDir);
+
+    m_autoSaver = new AutoSaver(&m_setModel, this);
+    m_autoSaver->setPath(QDir(autoSaveDir).filePath(AutoSaveFile));
+
+    QTimer::singleShot(0, this, SLOT(onCheckAutoSave()));
+    profiler.mark("Autosave");
 }
 
 MainWindow::~MainWindow()
 {
+    closeMirrors();
     delete ui;
 }
 
@@ -138,6 +200,25 @@ void MainWindow::onSliderMoved(int pos)
     m_scrollPos = pos;
 }
 
+void MainWindow::onTimelineStepClicked(Step *step)
+{
+    // Bring the step to the top of the staging area...
+    QRect rect = m_stagingArea->stepRect(step);
+    if (rect.isValid())
+    {
+        m_scrollPos = rect.top();
+        m_scrollArea->verticalScrollBar()->setValue(m_scrollPos);
+    }
+
+    // ...and select it in the outline, if that's open.
+    if (m_treeDock->isVisible())
+    {
+        QModelIndex index = m_setModel.indexForStep(step);
+        m_treeView->setCurrentIndex(index);
+        m_treeView->scrollTo(index);
+    }
+}
+
 
 void MainWindow::onShowAddMenu(const QPoint menuPos, Step *parent)
 {
@@ -176,6 +257,41 @@ void MainWindow::onShowAddMenu(const QPoint menuPos, Step *parent)
     }
 }
 
+void MainWindow::createShowTimeWidget()
+{
+    if (m_showtimeWidget)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // The single-paint canvas is the default; the widget tree can be chosen in the settings.
+    QSettings settings(AppRegKey);
+    ShowTimeWidget::Renderer renderer = (settings.value("showTimeRenderer").toString() == "widgets")
+            ? ShowTimeWidget::Renderer::Widgets
+            : ShowTimeWidget::Renderer::Canvas;
+
+    m_showtimeWidget = new ShowTimeWidget(&m_setModel, this, this, renderer);
+    m_showtimeWidget->hide();
+
+    // Lower this on slow machines, the bars then move in bigger steps.
+    if (settings.contains("progressFrameRate"))
+        m_showtimeWidget->setProgressFrameRate(settings.value("progressFrameRate").toInt());
+
+    QObject::connect(&m_setModel, SIGNAL(intervalStarted()), m_showtimeWidget, SLOT(onIntervalStarted()));
+    QObject::connect(&m_setModel, SIGNAL(setStarted()), m_showtimeWidget, SLOT(onSetStarted()));
+    QObject::connect(&m_setModel, SIGNAL(setPaused()), m_showtimeWidget, SLOT(onSetPaused()));
+    QObject::connect(&m_setModel, SIGNAL(setResumed()), m_showtimeWidget, SLOT(onSetResumed()));
+    QObject::connect(&m_setModel, SIGNAL(setComplete()), m_showtimeWidget, SLOT(onSetComplete()));
+    QObject::connect(&m_setModel, SIGNAL(setStopped()), m_showtimeWidget, SLOT(onSetStopped()));
+    QObject::connect(&m_setModel, SIGNAL(playbackError(QString)), m_showtimeWidget, SLOT(onPlaybackError(QString)));
+    QObject::connect(m_showtimeWidget, SIGNAL(toggleFullscreen()), this, SLOT(onToggleFullscreen()));
+    QObject::connect(m_showtimeWidget, SIGNAL(closeFullScreen()), this, SLOT(onCloseFullscreen()));
+    QObject::connect(m_showtimeWidget, SIGNAL(playPauseToggle()), this, SLOT(onPlayPauseToggle()));
+
+    StartupProfiler::instance().deferred("Show-time screen", timer.elapsed());
+}
+
 void MainWindow::UpdateFullscreen()
 {
     if (m_fullScreen)
@@ -205,6 +321,58 @@ void MainWindow::UpdateFullscreen()
 
         show();
     }
+
+    // The main show-time screen may have moved to another screen.
+    updateMirrors();
+}
+
+void MainWindow::onMirrorToggled(bool checked)
+{
+    Q_UNUSED(checked);
+    updateMirrors();
+}
+
+void MainWindow::updateMirrors()
+{
+    closeMirrors();
+
+    if (!m_mirrorAction->isChecked() || !m_showtimeWidget || !m_showtimeWidget->isVisible())
+        return;
+
+    // Every screen other than the one already showing the set gets a full-screen mirror.
+    QWindow *mainWindow = m_showtimeWidget->window()->windowHandle();
+    QScreen *mainScreen = mainWindow ? mainWindow->screen() : QGuiApplication::primaryScreen();
+
+    QSettings settings(AppRegKey);
+    for (QScreen *screen : QGuiApplication::screens())
+    {
+        if (screen == mainScreen)
+            continue;
+
+        // Each screen can have its own layout, e.g. just the countdown on an instructor's screen.
+        ShowTimeCanvas::Variant variant = (settings.value("screenLayouts/" + screen->name()).toString() == "countdown")
+                ? ShowTimeCanvas::Variant::Countdown
+                : ShowTimeCanvas::Variant::Full;
+
+        ShowTimeWindow *window = new ShowTimeWindow(nullptr);
+        window->setAttribute(Qt::WA_QuitOnClose, false);
+        window->setAttribute(Qt::WA_ShowWithoutActivating);
+
+        ShowTimeCanvas *canvas = new ShowTimeCanvas(this, window, variant);
+        window->setWidget(canvas);
+        window->setGeometry(screen->geometry());
+        window->showFullScreen();
+
+        m_showtimeWidget->addMirror(canvas);
+        m_mirrorWindows.append(window);
+    }
+}
+
+void MainWindow::closeMirrors()
+{
+    // The canvases go with their windows, which also removes them from the show-time widget.
+    qDeleteAll(m_mirrorWindows);
+    m_mirrorWindows.clear();
 }
 
 void MainWindow::onToggleFullscreen()
@@ -224,7 +392,9 @@ void MainWindow::closeEvent(QCloseEvent *event)
     QSettings settings(AppRegKey);
     settings.setValue("geometry", saveGeometry());
     settings.setValue("windowState", saveState());
+    settings.setValue("mirrorShowTime", m_mirrorAction->isChecked());
 
+    m_stagingArea->commitEdits();
     if (m_setModel.dirty())
     {
         QMessageBox::StandardButton button = QMessageBox::question(this, "Save current set",
@@ -247,6 +417,10 @@ void MainWindow::closeEvent(QCloseEvent *event)
         }
     }
 
+    // Clean exit, nothing to recover next time.
+    if (m_autoSaver)
+        m_autoSaver->discard();
+
     QMainWindow::closeEvent(event);
 }
 
@@ -261,6 +435,7 @@ void MainWindow::onSetStarted()
     ui->actionPause->setEnabled(true);
     ui->actionStop->setEnabled(true);
     ui->actionAddStep->setEnabled(false);
+    m_treeView->setEnabled(false);
 
     // Prevent screen-saver/hybernation. There doesn't seem to be a Qt way to do this.
 #ifdef Q_OS_WIN
@@ -274,6 +449,7 @@ void MainWindow::onSetPaused()
     ui->actionPause->setEnabled(false);
     ui->actionStop->setEnabled(true);
     ui->actionAddStep->setEnabled(false);
+    m_treeView->setEnabled(false);
 }
 
 void MainWindow::onSetResumed()
@@ -282,6 +458,7 @@ void MainWindow::onSetResumed()
     ui->actionPause->setEnabled(true);
     ui->actionStop->setEnabled(true);
     ui->actionAddStep->setEnabled(false);
+    m_treeView->setEnabled(false);
 }
 
 void MainWindow::onSetComplete()
@@ -289,7 +466,8 @@ void MainWindow::onSetComplete()
     ui->actionPlay->setEnabled(true);
     ui->actionPause->setEnabled(false);
     ui->actionStop->setEnabled(false);
-    ui->actionAddStep->setEnabled(false);
+    ui->actionAddStep->setEnabled(true);
+    m_treeView->setEnabled(true);
 
     if (m_fullScreen)
         onToggleFullscreen();
@@ -307,6 +485,7 @@ void MainWindow::onSetStopped()
     ui->actionPause->setEnabled(false);
     ui->actionStop->setEnabled(false);
     ui->actionAddStep->setEnabled(true);
+    m_treeView->setEnabled(true);
 
     onBackToStagingArea();
 
@@ -318,6 +497,9 @@ void MainWindow::onSetStopped()
 
 void MainWindow::on_actionPlay_triggered()
 {
+    m_stagingArea->commitEdits();
+    createShowTimeWidget();
+
     if (m_scrollArea && !m_scrollArea->isHidden())
     {
         m_scrollArea->setParent(nullptr);
@@ -327,12 +509,14 @@ void MainWindow::on_actionPlay_triggered()
     setCentralWidget(m_showtimeWidget);
     m_showtimeWidget->show();
     m_showtimeWidget->setFocus();
+    updateMirrors();
 
     m_setModel.startSet();
 }
 
 void MainWindow::on_actionNew_triggered()
 {
+    m_stagingArea->commitEdits();
     if (m_setModel.dirty()
         && QMessageBox::question(this, "Discard Unsaved Data", "Any unsaved changes will be lost. Continue?") != QMessageBox::Yes)
         return;
@@ -341,13 +525,18 @@ void MainWindow::on_actionNew_triggered()
 
 void MainWindow::on_actionOpen_triggered()
 {
+    m_stagingArea->commitEdits();
     if (m_setModel.dirty()
         && QMessageBox::question(this, "Discard Unsaved Data", "Any unsaved changes will be lost. Continue?") != QMessageBox::Yes)
         return;
 
     m_filePath = QFileDialog::getOpenFileName(this, "Open set", QString(), FileFilter);
     if (!m_filePath.isEmpty())
+    {
+        bool large = QFileInfo(m_filePath).size() > LazyLoadThreshold;
+        m_setModel.setLoadMode(large ? TurboSetModel::LoadMode::Lazy : TurboSetModel::LoadMode::Eager);
         m_setModel.deserialise(m_filePath);
+    }
 }
 
 void MainWindow::on_actionSave_triggered()
@@ -365,8 +554,174 @@ void MainWindow::on_actionSaveAs_triggered()
     save(true);
 }
 
+void MainWindow::on_actionOpenFromBundle_triggered()
+{
+    m_stagingArea->commitEdits();
+    if (m_setModel.dirty()
+        && QMessageBox::question(this, "Discard Unsaved Data", "Any unsaved changes will be lost. Continue?") != QMessageBox::Yes)
+        return;
+
+    QString path = QFileDialog::getOpenFileName(this, "Open bundle", QString(), BundleFilter);
+    if (path.isEmpty())
+        return;
+
+    SetBundle bundle;
+    QString error;
+    if (!bundle.open(path, &error))
+    {
+        QMessageBox::warning(this, "Open bundle", QString("Could not open bundle: %1").arg(error));
+        return;
+    }
+
+    // Only the index has been read at this point, the chosen set is read by seeking straight to it.
+    QStringList names;
+    for (const SetBundle::Entry &entry : bundle.entries())
+    {
+        QTime duration(0, 0, 0);
+        duration = duration.addSecs((int)entry.totalSeconds);
+        names << QString("%1. %2 (%3, %4 intervals)").arg(names.size() + 1).arg(entry.name, duration.toString("hh:mm:ss")).arg(entry.intervals);
+    }
+
+    if (names.isEmpty())
+    {
+        QMessageBox::information(this, "Open bundle", "The bundle is empty.");
+        return;
+    }
+
+    bool ok = false;
+    QString choice = QInputDialog::getItem(this, "Open from bundle", "Set:", names, 0, false, &ok);
+    if (!ok)
+        return;
+
+    if (!bundle.loadSet(names.indexOf(choice), m_setModel, &error))
+    {
+        QMessageBox::warning(this, "Open bundle", QString("Could not load set: %1").arg(error));
+        return;
+    }
+
+    // The set doesn't have a file of its own yet.
+    m_filePath.clear();
+}
+
+void MainWindow::on_actionAddToBundle_triggered()
+{
+    m_stagingArea->commitEdits();
+
+    QString path = QFileDialog::getSaveFileName(this, "Add to bundle", QString(), BundleFilter, nullptr, QFileDialog::DontConfirmOverwrite);
+    if (path.isEmpty())
+        return;
+
+    bool ok = false;
+    QString name = QInputDialog::getText(this, "Add to bundle", "Name of the set in the bundle:", QLineEdit::Normal,
+                                         QFileInfo(m_filePath).completeBaseName(), &ok);
+    if (!ok || name.isEmpty())
+        return;
+
+    QString error;
+    QList<SetBundle::Item> items;
+    items << SetBundle::makeItem(name, m_setModel);
+    if (!SetBundle::write(path, items, true, &error))
+        QMessageBox::warning(this, "Add to bundle", QString("Could not write bundle: %1").arg(error));
+}
+
+void MainWindow::on_actionImportWorkout_triggered()
+{
+    m_stagingArea->commitEdits();
+    if (m_setModel.dirty()
+        && QMessageBox::question(this, "Discard Unsaved Data", "Any unsaved changes will be lost. Continue?") != QMessageBox::Yes)
+        return;
+
+    QString path = QFileDialog::getOpenFileName(this, "Import workout", QString(), WorkoutFilter);
+    if (path.isEmpty())
+        return;
+
+    QString error;
+    QStringList warnings;
+    if (!WorkoutImporter::importFile(path, m_setModel, &error, &warnings))
+    {
+        QMessageBox::warning(this, "Import workout", QString("Could not import workout: %1").arg(error));
+        return;
+    }
+
+    // The imported set hasn't been saved as a set yet.
+    m_filePath.clear();
+
+    if (!warnings.isEmpty())
+        QMessageBox::information(this, "Import workout", "The workout was imported with some changes:\n\n" + warnings.join("\n"));
+}
+
+void MainWindow::on_actionImportFolder_triggered()
+{
+    if (m_importWatcher)
+    {
+        QMessageBox::information(this, "Import folder", "A folder is already being imported.");
+        return;
+    }
+
+    QString folder = QFileDialog::getExistingDirectory(this, "Folder of workouts to import");
+    if (folder.isEmpty())
+        return;
+
+    QString outputDir = QFileDialog::getExistingDirectory(this, "Folder to save the sets in", folder);
+    if (outputDir.isEmpty())
+        return;
+
+    // Conversion runs on the thread pool, the window stays usable meanwhile.
+    m_importWatcher = new QFutureWatcher<WorkoutImporter::FolderResult>(this);
+    connect(m_importWatcher, SIGNAL(finished()), this, SLOT(onImportFolderFinished()));
+    m_importWatcher->setFuture(QtConcurrent::run(&WorkoutImporter::importFolder, folder, outputDir));
+
+    statusBar()->showMessage("Importing workouts...");
+}
+
+void MainWindow::onImportFolderFinished()
+{
+    if (!m_importWatcher)
+    {
+        Q_ASSERT(false);
+        return;
+    }
+
+    WorkoutImporter::FolderResult result = m_importWatcher->result();
+    m_importWatcher->deleteLater();
+    m_importWatcher = nullptr;
+
+    statusBar()->clearMessage();
+
+    QString summary = QString("Imported %1 workout(s), %2 failed.").arg(result.imported).arg(result.failed);
+    if (!result.messages.isEmpty())
+        summary += "\n\n" + result.messages.join("\n");
+
+    QMessageBox::information(this, "Import folder", summary);
+}
+
+void MainWindow::on_actionExportFit_triggered()
+{
+    m_stagingArea->commitEdits();
+
+    if (m_setModel.isEmpty())
+    {
+        QMessageBox::information(this, "Export FIT workout", "There is nothing to export.");
+        return;
+    }
+
+    QString suggested;
+    if (!m_filePath.isEmpty())
+        suggested = QFileInfo(m_filePath).completeBaseName() + "." + FitExporter::FileExtension;
+
+    QString path = QFileDialog::getSaveFileName(this, "Export FIT workout", suggested, FitFilter);
+    if (path.isEmpty())
+        return;
+
+    QString error;
+    if (!FitExporter::exportFile(m_setModel, path, &error))
+        QMessageBox::warning(this, "Export FIT workout", QString("Could not export workout: %1").arg(error));
+}
+
 bool MainWindow::save(bool forcePrompt)
 {
+    m_stagingArea->commitEdits();
+
     if (m_filePath.isEmpty() || forcePrompt)
     {
         m_filePath = QFileDialog::getSaveFileName(this, "Save Set", QString(), FileFilter);
@@ -374,7 +729,13 @@ bool MainWindow::save(bool forcePrompt)
             return false;
     }
 
-    return m_setModel.serialise(m_filePath);
+    if (!m_setModel.serialise(m_filePath))
+        return false;
+
+    if (m_autoSaver)
+        m_autoSaver->discard();
+
+    return true;
 }
 
 void MainWindow::on_actionPause_triggered()
@@ -395,6 +756,8 @@ void MainWindow::onBackToStagingArea()
         return;
     }
 
+    closeMirrors();
+
     m_showtimeWidget->setParent(nullptr);
     m_showtimeWidget->hide();
 
@@ -413,3 +776,22 @@ void MainWindow::onCloseFullscreen()
     m_fullScreen = false;
     UpdateFullscreen();
 }
+
+void MainWindow::onCheckAutoSave()
+{
+    if (!m_autoSaver || !m_autoSaver->hasSnapshot())
+        return;
+
+    QMessageBox::StandardButton button = QMessageBox::question(this, "Recover unsaved set",
+                                                               "The previous session did not exit cleanly and has left unsaved changes behind. Would you like to recover them?");
+    if (button == QMessageBox::Yes && m_setModel.deserialise(m_autoSaver->path()))
+    {
+        // The recovered set has never been saved by the user, so keep it flagged as such.
+        m_filePath.clear();
+        m_setModel.markDirty();
+    }
+    else
+    {
+        m_autoSaver->discard();
+    }
+}
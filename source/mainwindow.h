@@ -7,9 +7,14 @@
 
 #include <QMainWindow>
 #include <QScrollArea>
+#include <QFutureWatcher>
 #include "stagingarea.h"
+#include "settreeview.h"
+#include "timelineview.h"
 #include "showtimewidget.h"
 #include "turbosetmodel.h"
+#include "autosaver.h"
+#include "workoutimporter.h"
 #include "QtAwesome/QtAwesome.h"
 #include "ifontawesome.h"
 
@@ -18,6 +23,7 @@ class MainWindow;
 }
 
 class QCloseEvent;
+class QDockWidget;
 
 /*! The main application window */
 class MainWindow : public QMainWindow, public IFontAwesome
@@ -55,6 +61,11 @@ private slots:
     void on_actionSave_triggered();
     void on_actionExit_triggered();
     void on_actionSaveAs_triggered();
+    void on_actionOpenFromBundle_triggered();
+    void on_actionAddToBundle_triggered();
+    void on_actionImportWorkout_triggered();
+    void on_actionImportFolder_triggered();
+    void on_actionExportFit_triggered();
     void on_actionPlay_triggered();
     void on_actionPause_triggered();
     void on_actionStop_triggered();
@@ -62,19 +73,34 @@ private slots:
     void onBackToStagingArea();
     void onPlayPauseToggle();
     void onCloseFullscreen();
+    void onCheckAutoSave();
+    void onImportFolderFinished();
+    void onTimelineStepClicked(Step *step);
+    void onMirrorToggled(bool checked);
+    void updateMirrors();
 
 protected:
     bool save(bool forcePrompt);
 
     void UpdateFullscreen();
+    void createShowTimeWidget();
+    void closeMirrors();
 
 protected:
     Ui::MainWindow *ui;
     QScrollArea *m_scrollArea;
     StagingArea *m_stagingArea;
+    QDockWidget *m_treeDock;
+    SetTreeView *m_treeView;
+    QDockWidget *m_timelineDock;
+    TimelineView *m_timeline;
     ShowTimeWindow *m_showtimeWindow;
     ShowTimeWidget *m_showtimeWidget;
+    QList<ShowTimeWindow*> m_mirrorWindows;
+    QAction *m_mirrorAction;
     TurboSetModel m_setModel;
+    AutoSaver *m_autoSaver;
+    QFutureWatcher<WorkoutImporter::FolderResult> *m_importWatcher;
     QString m_filePath;
     QtAwesome *m_fontAwesome;
     int m_scrollPos;
@@ -4,8 +4,8 @@
 
 #include "nowplayingwidget.h"
 #include "stepresources.h"
+#include "framescheduler.h"
 #include <QPainter>
-#include <QTime>
 #include <QFontMetrics>
 
 static const int IconBoxSize = 50;
@@ -15,6 +15,8 @@ static const int TimeMargin = 15;
 NowPlayingWidget::NowPlayingWidget(IFontAwesome *fontAwesome, QWidget *parent)
     : ShowTimeStepWidget(fontAwesome, parent)
     , m_iteration(nullptr)
+    , m_countdown(nullptr)
+    , m_progress(nullptr)
     , m_typeFont(FontName, 18, QFont::Bold)
     , m_textFont(FontName, 12, QFont::Bold)
     , m_timeFont(FontName, 18, QFont::Bold)
@@ -35,10 +37,8 @@ NowPlayingWidget::NowPlayingWidget(IFontAwesome *fontAwesome, QWidget *parent)
     m_iteration->setAlignment(Qt::AlignVCenter | Qt::AlignRight);
     m_topRowLayout->addWidget(m_iteration);
 
-    m_time = new QLabel(this);
-    m_time->setFont(m_timeFont);
-    m_time->setAlignment(Qt::AlignLeft | Qt::AlignTop);
-    m_time->setStyleSheet("color: #a9da88");
+    m_countdown = new CountdownWidget(m_timeFont, QColor(0xa9, 0xda, 0x88), this);
+    m_progress = new ProgressWidget(QColor(0xa9, 0xda, 0x88), QColor(0x88, 0xb4, 0xda), this);
 
     m_text = new QLabel(this);
     m_text->setFont(m_textFont);
@@ -57,7 +57,7 @@ void NowPlayingWidget::setInterval(Interval *nowPlaying)
     m_type->setText(TypeToString(nowPlaying->type()));
 
     adjustLayout();
-    repaint();
+    FrameScheduler::instance().schedule(this);
 }
 
 void NowPlayingWidget::setIterations(const bool loop, const uint32_t currentIteration, const uint32_t totalIterations)
@@ -81,20 +81,22 @@ void NowPlayingWidget::setIterations(const bool loop, const uint32_t currentIter
     }
 
     adjustLayout();
-    repaint();
+    FrameScheduler::instance().schedule(this);
 }
 
 void NowPlayingWidget::setTimeRemaining(const uint secondsRemaining)
 {
-    QTime time(0, 0, 0);
-    time = time.addSecs(secondsRemaining);
-    m_time->setText(time.toString("hh:mm:ss"));
-    m_time->repaint();
+    m_countdown->setSecondsRemaining(secondsRemaining);
+}
+
+void NowPlayingWidget::setProgress(const qreal interval, const qreal set)
+{
+    m_progress->setProgress(interval, set);
 }
 
 void NowPlayingWidget::adjustLayout()
 {
-    if (!m_topRow || !m_time || !m_text)
+    if (!m_topRow || !m_countdown || !m_progress || !m_text)
     {
         Q_ASSERT(false);
         return;
@@ -107,8 +109,10 @@ void NowPlayingWidget::adjustLayout()
     // The following *should* be unneccessary but contents of the layout have not yet been updated at this point (async?)
     m_topRowLayout->setGeometry(m_topRow->rect());
 
-    m_time->setGeometry(Margin, headerHeight, width() - (Margin * 2), ((height() - headerHeight) * 2) / 3);
-    m_text->setGeometry(Margin, m_time->geometry().bottom() + TimeMargin, width() - (Margin * 2), height() - m_time->geometry().bottom() - (TimeMargin * 2));
+    int bodyHeight = height() - headerHeight;
+    m_countdown->setGeometry(Margin, headerHeight, width() - (Margin * 2), (bodyHeight * 3) / 5);
+    m_progress->setGeometry(Margin, m_countdown->geometry().bottom() + 1, width() - (Margin * 2), bodyHeight / 8);
+    m_text->setGeometry(Margin, m_progress->geometry().bottom() + TimeMargin, width() - (Margin * 2), height() - m_progress->geometry().bottom() - (TimeMargin * 2));
 
     if (m_interval)
         DrawFaIconToLabel(m_icon, TypeToFaIcon(m_interval->type()), m_fontAwesome);
@@ -116,7 +120,6 @@ void NowPlayingWidget::adjustLayout()
     UpdateLabelFontSize(m_type);
     if (!m_iteration->isHidden())
         UpdateLabelFontSize(m_iteration);
-    UpdateLabelFontSize(m_time);
     UpdateLabelFontSize(m_text);
 }
 
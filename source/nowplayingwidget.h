@@ -13,6 +13,8 @@
 #include <QPixmap>
 #include "step.h"
 #include "showtimestepwidget.h"
+#include "countdownwidget.h"
+#include "progressbars.h"
 
 /*! Widget representing the current interval in progress */
 class NowPlayingWidget : public ShowTimeStepWidget
@@ -24,6 +26,7 @@ public:
     void setInterval(Interval *nowPlaying);
     void setIterations(const bool loop, const uint32_t currentIteration, const uint32_t totalIterations);
     void setTimeRemaining(const uint secondsRemaining);
+    void setProgress(const qreal interval, const qreal set);
 
 protected: // ShowTimeStepWidget
     void adjustLayout() override;
@@ -31,6 +34,8 @@ protected: // ShowTimeStepWidget
 
 protected:
     QLabel      *m_iteration;
+    CountdownWidget *m_countdown;
+    ProgressWidget *m_progress;
     QFont       m_typeFont;
     QFont       m_textFont;
     QFont       m_timeFont;
@@ -0,0 +1,137 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "progressbars.h"
+#include "framescheduler.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <cmath>
+
+static const int BorderWidth = 2;
+static const QColor TrackColour(0x50, 0x50, 0x50);
+static const QColor BorderColour(0x33, 0x33, 0x33);
+
+ProgressBars::ProgressBars(const QColor &intervalColour, const QColor &setColour)
+    : m_intervalColour(intervalColour)
+    , m_setColour(setColour)
+    , m_pixelRatio(1.0)
+{
+}
+
+void ProgressBars::resize(const QSize &size, const qreal pixelRatio)
+{
+    m_pixelRatio = pixelRatio;
+
+    if (size.width() <= (BorderWidth * 2) || size.height() <= (BorderWidth * 4))
+    {
+        m_background = QPixmap();
+        m_intervalTrack = m_setTrack = QRect();
+        return;
+    }
+
+    // The interval gets the larger bar, it's the one riders are working to.
+    int intervalHeight = (size.height() * 3) / 5;
+    int gap = size.height() / 10;
+    QRect intervalBar(0, 0, size.width(), intervalHeight);
+    QRect setBar(0, intervalHeight + gap, size.width(), size.height() - intervalHeight - gap);
+
+    m_intervalTrack = intervalBar.adjusted(BorderWidth, BorderWidth, -BorderWidth, -BorderWidth);
+    m_setTrack = setBar.adjusted(BorderWidth, BorderWidth, -BorderWidth, -BorderWidth);
+
+    m_background = QPixmap(size * pixelRatio);
+    m_background.setDevicePixelRatio(pixelRatio);
+    m_background.fill(Qt::transparent);
+
+    QPainter painter(&m_background);
+    for (const QRect &bar : { intervalBar, setBar })
+    {
+        painter.fillRect(bar, BorderColour);
+    }
+    painter.fillRect(m_intervalTrack, TrackColour);
+    painter.fillRect(m_setTrack, TrackColour);
+}
+
+qreal ProgressBars::edge(const qreal fraction) const
+{
+    // Both tracks are the same width, so they share their edges.
+    qreal clamped = qBound<qreal>(0, fraction, 1);
+    return qRound(clamped * m_intervalTrack.width() * m_pixelRatio) / m_pixelRatio;
+}
+
+QRect ProgressBars::changedRect(const qreal fromInterval, const qreal fromSet, const qreal toInterval, const qreal toSet) const
+{
+    return strip(m_intervalTrack, fromInterval, toInterval) | strip(m_setTrack, fromSet, toSet);
+}
+
+void ProgressBars::paint(QPainter &painter, const QPoint &origin, const qreal intervalEdge, const qreal setEdge, const QRect &area) const
+{
+    if (m_background.isNull())
+        return;
+
+    // Only the part of the background that's being repainted is copied.
+    QRect local = area.translated(-origin) & QRect(QPoint(0, 0), m_background.size() / m_pixelRatio);
+    if (local.isEmpty())
+        return;
+
+    QRectF source(local.x() * m_pixelRatio, local.y() * m_pixelRatio, local.width() * m_pixelRatio, local.height() * m_pixelRatio);
+    painter.drawPixmap(QRectF(local.translated(origin)), m_background, source);
+
+    painter.save();
+    painter.translate(origin);
+    paintBar(painter, m_intervalTrack, intervalEdge, m_intervalColour, local);
+    paintBar(painter, m_setTrack, setEdge, m_setColour, local);
+    painter.restore();
+}
+
+QRect ProgressBars::strip(const QRect &track, const qreal from, const qreal to) const
+{
+    if (from == to)
+        return QRect();
+
+    // Edges can fall between logical pixels, so take in the whole of any pixel they touch.
+    int left = track.left() + (int)std::floor(std::min(from, to));
+    int right = track.left() + (int)std::ceil(std::max(from, to));
+    return QRect(QPoint(left, track.top()), QPoint(right, track.bottom()));
+}
+
+void ProgressBars::paintBar(QPainter &painter, const QRect &track, const qreal barEdge, const QColor &colour, const QRect &area) const
+{
+    QRectF fill = QRectF(track.left(), track.top(), barEdge, track.height()) & QRectF(area);
+    if (!fill.isEmpty())
+        painter.fillRect(fill, colour);
+}
+
+
+ProgressWidget::ProgressWidget(const QColor &intervalColour, const QColor &setColour, QWidget *parent)
+    : QWidget(parent)
+    , m_bars(intervalColour, setColour)
+    , m_interval(0)
+    , m_set(0)
+{
+    // Only the bars are painted, the parent shows through around them.
+    setAttribute(Qt::WA_NoSystemBackground);
+}
+
+void ProgressWidget::setProgress(const qreal interval, const qreal set)
+{
+    QRect changed = m_bars.changedRect(m_bars.edge(m_interval), m_bars.edge(m_set), m_bars.edge(interval), m_bars.edge(set));
+    m_interval = interval;
+    m_set = set;
+
+    if (!changed.isEmpty())
+        FrameScheduler::instance().schedule(this, changed);
+}
+
+void ProgressWidget::resizeEvent(QResizeEvent *event)
+{
+    Q_UNUSED(event);
+    m_bars.resize(size(), devicePixelRatioF());
+    update();
+}
+
+void ProgressWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    m_bars.paint(painter, QPoint(0, 0), m_bars.edge(m_interval), m_bars.edge(m_set), event->rect());
+}
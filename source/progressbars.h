@@ -0,0 +1,72 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef PROGRESSBARS_H
+#define PROGRESSBARS_H
+
+#include <QWidget>
+#include <QColor>
+#include <QPixmap>
+#include <QRect>
+
+class QPainter;
+
+/*!
+ * Paints the progress through the current interval and through the whole set as a pair
+ * of bars, one above the other.
+ *
+ * The empty tracks are rasterised once per size, so painting is a copy from that
+ * background plus a fill up to each bar's edge. The edges are snapped to device pixels
+ * and only the strip between an old and new edge needs repainting as the bars move.
+ */
+class ProgressBars
+{
+public:
+    ProgressBars(const QColor &intervalColour, const QColor &setColour);
+
+    //! Rebuild the background to fill size (in logical pixels) on a screen with the given pixel ratio.
+    void resize(const QSize &size, const qreal pixelRatio);
+
+    //! Snap a fraction (0 to 1) of the width to the device pixel the edge of a bar would be drawn at.
+    qreal edge(const qreal fraction) const;
+
+    //! Get the area, relative to the bars' origin, which differs between two sets of edges.
+    QRect changedRect(const qreal fromInterval, const qreal fromSet, const qreal toInterval, const qreal toSet) const;
+
+    void paint(QPainter &painter, const QPoint &origin, const qreal intervalEdge, const qreal setEdge, const QRect &area) const;
+
+protected:
+    QRect strip(const QRect &track, const qreal from, const qreal to) const;
+    void paintBar(QPainter &painter, const QRect &track, const qreal barEdge, const QColor &colour, const QRect &area) const;
+
+protected:
+    QColor      m_intervalColour;
+    QColor      m_setColour;
+    QPixmap     m_background;
+    QRect       m_intervalTrack;
+    QRect       m_setTrack;
+    qreal       m_pixelRatio;
+};
+
+/*! Displays interval and set progress, repainting only the strips where the bars have moved */
+class ProgressWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    ProgressWidget(const QColor &intervalColour, const QColor &setColour, QWidget *parent = nullptr);
+
+    //! Set the fractions (0 to 1) of the interval and of the set that have been played.
+    void setProgress(const qreal interval, const qreal set);
+
+protected: // Event handlers
+    void resizeEvent(QResizeEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+
+protected:
+    ProgressBars    m_bars;
+    qreal           m_interval;
+    qreal           m_set;
+};
+
+#endif // PROGRESSBARS_H
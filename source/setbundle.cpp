@@ -0,0 +1,355 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "setbundle.h"
+#include "setvalidator.h"
+#include "turbosetmodel.h"
+#include <QSaveFile>
+#include <QDataStream>
+#include <algorithm>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+const QString SetBundle::FileExtension = "tttbundle";
+
+static const char       Magic[4]    = { 'T', 'T', 'T', 'B' };
+static const quint16    Version     = 1;
+static const int        HeaderSize  = 32;
+
+/*
+ * Header layout (little-endian):
+ *   0  char[4]  magic "TTTB"
+ *   4  quint16  version
+ *   6  quint16  CRC-16 of the index
+ *   8  quint32  number of entries
+ *  12  quint64  offset of the index
+ *  20  quint32  size of the index in bytes
+ *  24  (reserved, zero)
+ */
+
+static void setError(QString *errorMsg, const QString &error)
+{
+    if (errorMsg)
+        *errorMsg = error;
+}
+
+static bool SyncToDisk(QFile &file)
+{
+    // QFile::flush() only hands the data to the OS, this waits until it's on the disk.
+    if (!file.flush())
+        return false;
+
+#ifdef Q_OS_WIN
+    return ::_commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+SetBundle::SetBundle()
+{
+}
+
+bool SetBundle::open(const QString &path, QString *errorMsg /*= nullptr*/)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        setError(errorMsg, m_file.errorString());
+        return false;
+    }
+
+    quint64 indexEnd = 0;
+    if (!readIndex(m_file, m_entries, indexEnd, errorMsg))
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void SetBundle::close()
+{
+    m_file.close();
+    m_entries.clear();
+}
+
+bool SetBundle::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString SetBundle::path() const
+{
+    return m_file.fileName();
+}
+
+const QList<SetBundle::Entry> &SetBundle::entries() const
+{
+    return m_entries;
+}
+
+QByteArray SetBundle::readSet(const int index, QString *errorMsg /*= nullptr*/)
+{
+    if (!isOpen() || index < 0 || index >= m_entries.size())
+    {
+        setError(errorMsg, "No such set in bundle");
+        return QByteArray();
+    }
+
+    const Entry &entry = m_entries.at(index);
+    if (!m_file.seek((qint64)entry.offset))
+    {
+        setError(errorMsg, m_file.errorString());
+        return QByteArray();
+    }
+
+    QByteArray xml = m_file.read(entry.size);
+    if (xml.size() != (int)entry.size || qChecksum(xml.constData(), xml.size()) != entry.checksum)
+    {
+        setError(errorMsg, QString("Set '%1' is corrupt").arg(entry.name));
+        return QByteArray();
+    }
+
+    return xml;
+}
+
+bool SetBundle::loadSet(const int index, TurboSetModel &model, QString *errorMsg /*= nullptr*/)
+{
+    QByteArray xml = readSet(index, errorMsg);
+    if (xml.isEmpty())
+        return false;
+
+    return model.fromXml(xml, errorMsg);
+}
+
+SetBundle::Item SetBundle::makeItem(const QString &name, const TurboSetModel &model)
+{
+    SetStatistics stats = SetValidator::statistics(model.getIntervals());
+
+    Item item;
+    item.name = name;
+    item.xml = model.toXml();
+    item.intervals = (quint32)stats.playedIntervals;
+    item.totalSeconds = stats.totalSeconds;
+    return item;
+}
+
+bool SetBundle::write(const QString &path, const QList<Item> &items, const bool append, QString *errorMsg /*= nullptr*/)
+{
+    QList<Entry> entries;
+    quint64 offset = HeaderSize;
+
+    QFile existing(path);
+    bool appending = append && existing.exists();
+
+    if (appending)
+    {
+        if (!existing.open(QIODevice::ReadWrite))
+        {
+            setError(errorMsg, existing.errorString());
+            return false;
+        }
+
+        quint64 indexEnd = 0;
+        if (!readIndex(existing, entries, indexEnd, errorMsg))
+            return false;
+
+        // New content goes after everything already in the file, including the current index,
+        // which stays valid until the header is switched over to the new one.
+        offset = std::max((quint64)existing.size(), indexEnd);
+    }
+
+    quint64 dataStart = offset;
+    for (const Item &item : items)
+    {
+        Entry entry;
+        entry.name = item.name;
+        entry.offset = offset;
+        entry.size = (quint32)item.xml.size();
+        entry.checksum = qChecksum(item.xml.constData(), item.xml.size());
+        entry.intervals = item.intervals;
+        entry.totalSeconds = item.totalSeconds;
+        entries.append(entry);
+
+        offset += entry.size;
+    }
+
+    QByteArray index = encodeIndex(entries);
+    QByteArray header = encodeHeader((quint32)entries.size(), offset, (quint32)index.size());
+    quint16 indexChecksum = qChecksum(index.constData(), index.size());
+    header[6] = (char)(indexChecksum & 0xff);
+    header[7] = (char)(indexChecksum >> 8);
+
+    if (appending)
+    {
+        if (!existing.seek((qint64)dataStart))
+        {
+            setError(errorMsg, existing.errorString());
+            return false;
+        }
+
+        // A short write leaves the header pointing at the old index, so the bundle is unchanged.
+        for (const Item &item : items)
+        {
+            if (existing.write(item.xml) != item.xml.size())
+            {
+                setError(errorMsg, existing.errorString());
+                return false;
+            }
+        }
+
+        if (existing.write(index) != index.size())
+        {
+            setError(errorMsg, existing.errorString());
+            return false;
+        }
+
+        // Make sure the new data is on disk before pointing the header at it, the header is
+        // rewritten in place so it mustn't reach the disk first.
+        if (!SyncToDisk(existing))
+        {
+            setError(errorMsg, "Could not write the bundle to disk");
+            return false;
+        }
+
+        if (!existing.seek(0) || existing.write(header) != header.size() || !SyncToDisk(existing))
+        {
+            setError(errorMsg, existing.errorString());
+            return false;
+        }
+
+        return true;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        setError(errorMsg, file.errorString());
+        return false;
+    }
+
+    file.write(header);
+    for (const Item &item : items)
+    {
+        file.write(item.xml);
+    }
+    file.write(index);
+
+    if (!file.commit())
+    {
+        setError(errorMsg, file.errorString());
+        return false;
+    }
+
+    return true;
+}
+
+bool SetBundle::readIndex(QFile &file, QList<Entry> &entries, quint64 &indexEnd, QString *errorMsg)
+{
+    entries.clear();
+
+    if (!file.seek(0))
+    {
+        setError(errorMsg, file.errorString());
+        return false;
+    }
+
+    QByteArray header = file.read(HeaderSize);
+    if (header.size() != HeaderSize || memcmp(header.constData(), Magic, sizeof(Magic)) != 0)
+    {
+        setError(errorMsg, "Not a set bundle");
+        return false;
+    }
+
+    QDataStream headerStream(header);
+    headerStream.setByteOrder(QDataStream::LittleEndian);
+    headerStream.skipRawData(sizeof(Magic));
+
+    quint16 version = 0, indexChecksum = 0;
+    quint32 count = 0, indexSize = 0;
+    quint64 indexOffset = 0;
+    headerStream >> version >> indexChecksum >> count >> indexOffset >> indexSize;
+
+    if (version > Version)
+    {
+        setError(errorMsg, QString("Unsupported bundle version %1").arg(version));
+        return false;
+    }
+
+    quint64 fileSize = (quint64)file.size();
+    if (indexOffset < (quint64)HeaderSize || indexOffset + indexSize > fileSize || !file.seek((qint64)indexOffset))
+    {
+        setError(errorMsg, "Bundle index is missing or truncated");
+        return false;
+    }
+
+    QByteArray index = file.read(indexSize);
+    if (index.size() != (int)indexSize || qChecksum(index.constData(), index.size()) != indexChecksum)
+    {
+        setError(errorMsg, "Bundle index is corrupt");
+        return false;
+    }
+
+    QDataStream stream(index);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    for (quint32 i = 0; i < count; ++i)
+    {
+        QByteArray name;
+        Entry entry;
+        stream >> name >> entry.offset >> entry.size >> entry.checksum >> entry.intervals >> entry.totalSeconds;
+        entry.name = QString::fromUtf8(name);
+
+        if (stream.status() != QDataStream::Ok || entry.offset + entry.size > indexOffset)
+        {
+            entries.clear();
+            setError(errorMsg, "Bundle index is corrupt");
+            return false;
+        }
+
+        entries.append(entry);
+    }
+
+    indexEnd = indexOffset + indexSize;
+    return true;
+}
+
+QByteArray SetBundle::encodeIndex(const QList<Entry> &entries)
+{
+    QByteArray index;
+    QDataStream stream(&index, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    for (const Entry &entry : entries)
+    {
+        stream << entry.name.toUtf8() << entry.offset << entry.size << entry.checksum << entry.intervals << entry.totalSeconds;
+    }
+
+    return index;
+}
+
+QByteArray SetBundle::encodeHeader(const quint32 count, const quint64 indexOffset, const quint32 indexSize)
+{
+    QByteArray header;
+    header.reserve(HeaderSize);
+
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData(Magic, sizeof(Magic));
+    stream << Version << (quint16)0 << count << indexOffset << indexSize;
+
+    header.append(QByteArray(HeaderSize - header.size(), '\0'));
+    return header;
+}
@@ -0,0 +1,93 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef SETBUNDLE_H
+#define SETBUNDLE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QFile>
+
+class TurboSetModel;
+
+/*!
+ * A bundle packs many sets into a single file.
+ *
+ * The file starts with a fixed-size header holding the location of an index, which lists the
+ * offset, size and summary metadata of every set in the bundle. Opening a bundle only reads
+ * the header and index; individual sets are read by seeking straight to them.
+ *
+ * Appending writes the new sets and a new index after the existing content and only then
+ * updates the header, so an interrupted append leaves the bundle as it was.
+ */
+class SetBundle
+{
+public:
+    static const QString FileExtension;
+
+    /*! A set within the bundle, as described by the index */
+    struct Entry
+    {
+        QString name;
+        quint64 offset;         //!< Offset of the set's XML from the start of the file.
+        quint32 size;           //!< Size of the set's XML in bytes.
+        quint16 checksum;       //!< CRC-16 of the set's XML.
+        quint32 intervals;      //!< Number of intervals played back, loops expanded.
+        quint64 totalSeconds;   //!< Playback duration, loops expanded.
+    };
+
+    /*! A set to be written to a bundle */
+    struct Item
+    {
+        QString name;
+        QByteArray xml;
+        quint32 intervals;
+        quint64 totalSeconds;
+    };
+
+    SetBundle();
+
+    /*!
+     * Open a bundle and read its index.
+     * \param path The bundle file.
+     * \param errorMsg Optional, receives a description of the problem on failure.
+     */
+    bool open(const QString &path, QString *errorMsg = nullptr);
+    void close();
+
+    bool isOpen() const;
+    QString path() const;
+
+    const QList<Entry>& entries() const;
+
+    //! Read the XML of a single set by seeking to it.
+    QByteArray readSet(const int index, QString *errorMsg = nullptr);
+
+    //! Read a single set into a model, replacing its current contents.
+    bool loadSet(const int index, TurboSetModel &model, QString *errorMsg = nullptr);
+
+    //! Build an item from the current contents of a model.
+    static Item makeItem(const QString &name, const TurboSetModel &model);
+
+    /*!
+     * Write sets to a bundle.
+     * \param path The bundle file.
+     * \param items The sets to write.
+     * \param append If true and the bundle exists, add the items to it rather than replacing it.
+     * \param errorMsg Optional, receives a description of the problem on failure.
+     */
+    static bool write(const QString &path, const QList<Item> &items, const bool append, QString *errorMsg = nullptr);
+
+protected:
+    static bool readIndex(QFile &file, QList<Entry> &entries, quint64 &indexEnd, QString *errorMsg);
+    static QByteArray encodeIndex(const QList<Entry> &entries);
+    static QByteArray encodeHeader(const quint32 count, const quint64 indexOffset, const quint32 indexSize);
+
+protected:
+    QFile m_file;
+    QList<Entry> m_entries;
+};
+
+#endif // SETBUNDLE_H
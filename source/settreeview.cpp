@@ -0,0 +1,166 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "settreeview.h"
+#include "turbosetmodel.h"
+#include "stepresources.h"
+
+#include <QPainter>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QMenu>
+#include <QTime>
+#include <QContextMenuEvent>
+#include <algorithm>
+
+static const int Margin = 6;
+static const int NameWidth = 100;
+static const int DurationWidth = 80;
+
+StepItemDelegate::StepItemDelegate(IFontAwesome *fontAwesome, QObject *parent)
+    : QStyledItemDelegate(parent)
+    , m_fontAwesome(fontAwesome)
+    , m_labelFont(FontName, 10, QFont::Bold)
+    , m_textFont(FontName, 10, QFont::Normal)
+{
+    Q_ASSERT(fontAwesome);
+}
+
+void StepItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    StepType type = (StepType)index.data(TurboSetModel::TypeRole).toInt();
+    QRect rect = option.rect.adjusted(0, 1, 0, -1);
+
+    painter->save();
+
+    painter->fillRect(rect, TypeToBgColour(type));
+    if (option.state & QStyle::State_Selected)
+    {
+        painter->setPen(QPen(option.palette.highlight(), 2));
+        painter->drawRect(rect.adjusted(1, 1, -1, -1));
+    }
+
+    int iconSize = rect.height() - (Margin * 2);
+    QRect iconRect(rect.left() + Margin, rect.top() + Margin, iconSize, iconSize);
+    m_fontAwesome->faIcon(TypeToFaIcon(type)).paint(painter, iconRect);
+
+    QRect nameRect(iconRect.right() + Margin, rect.top(), NameWidth, rect.height());
+    painter->setPen(Qt::black);
+    painter->setFont(m_labelFont);
+    painter->drawText(nameRect, Qt::AlignLeft | Qt::AlignVCenter, TypeToString(type));
+
+    QTime duration(0, 0);
+    duration = duration.addSecs(index.data(TurboSetModel::DurationRole).toInt());
+    QRect durationRect(nameRect.right() + Margin, rect.top(), DurationWidth, rect.height());
+    painter->setFont(m_textFont);
+    painter->drawText(durationRect, Qt::AlignLeft | Qt::AlignVCenter, duration.toString("hh:mm:ss"));
+
+    // Only the first line of a description fits in a row.
+    QRect textRect = editorRect(rect);
+    QString text = index.data(Qt::DisplayRole).toString().section('\n', 0, 0);
+    text = QFontMetrics(m_textFont).elidedText(text, Qt::ElideRight, textRect.width());
+    painter->drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter, text);
+
+    painter->restore();
+}
+
+QSize StepItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(index);
+    return QSize(option.rect.width(), RowHeight);
+}
+
+QWidget* StepItemDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(option);
+
+    if ((StepType)index.data(TurboSetModel::TypeRole).toInt() == StepType::Loop)
+    {
+        QSpinBox *spinBox = new QSpinBox(parent);
+        spinBox->setFont(m_textFont);
+        spinBox->setRange(1, 1000);
+        spinBox->setPrefix("Repeat x");
+        return spinBox;
+    }
+
+    QLineEdit *lineEdit = new QLineEdit(parent);
+    lineEdit->setFont(m_textFont);
+    return lineEdit;
+}
+
+void StepItemDelegate::setEditorData(QWidget *editor, const QModelIndex &index) const
+{
+    if (QSpinBox *spinBox = qobject_cast<QSpinBox*>(editor))
+        spinBox->setValue(index.data(TurboSetModel::IterationsRole).toInt());
+    else if (QLineEdit *lineEdit = qobject_cast<QLineEdit*>(editor))
+        lineEdit->setText(index.data(TurboSetModel::TextRole).toString());
+}
+
+void StepItemDelegate::setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const
+{
+    if (QSpinBox *spinBox = qobject_cast<QSpinBox*>(editor))
+        model->setData(index, spinBox->value(), TurboSetModel::IterationsRole);
+    else if (QLineEdit *lineEdit = qobject_cast<QLineEdit*>(editor))
+        model->setData(index, lineEdit->text(), TurboSetModel::TextRole);
+}
+
+void StepItemDelegate::updateEditorGeometry(QWidget *editor, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(index);
+    editor->setGeometry(editorRect(option.rect).adjusted(0, 4, 0, -4));
+}
+
+QRect StepItemDelegate::editorRect(const QRect &row) const
+{
+    int left = row.left() + Margin + (row.height() - (Margin * 2)) + Margin + NameWidth + Margin + DurationWidth + Margin;
+    return QRect(left, row.top(), std::max(row.right() - Margin - left, 0), row.height());
+}
+
+SetTreeView::SetTreeView(TurboSetModel *model, IFontAwesome *fontAwesome, QWidget *parent)
+    : QTreeView(parent)
+    , m_model(model)
+    , m_fontAwesome(fontAwesome)
+{
+    Q_ASSERT(model && fontAwesome);
+
+    setModel(m_model);
+    setItemDelegate(new StepItemDelegate(m_fontAwesome, this));
+    setHeaderHidden(true);
+    setUniformRowHeights(true); // Lets the view skip measuring rows in large sets
+    setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::EditKeyPressed);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+
+    QObject::connect(this, SIGNAL(deleted(Step*)), m_model, SLOT(onStepDeleted(Step*)), Qt::DirectConnection);
+    QObject::connect(this, SIGNAL(movedUp(Step*)), m_model, SLOT(onStepMovedUp(Step*)), Qt::DirectConnection);
+    QObject::connect(this, SIGNAL(movedDown(Step*)), m_model, SLOT(onStepMovedDown(Step*)), Qt::DirectConnection);
+    QObject::connect(this, SIGNAL(typeChanged(Step*,StepType)), m_model, SLOT(onTypeChanged(Step*,StepType)), Qt::DirectConnection);
+}
+
+void SetTreeView::contextMenuEvent(QContextMenuEvent *event)
+{
+    Step *step = m_model->stepForIndex(indexAt(event->pos()));
+    if (!step)
+        return;
+
+    QMenu menu(this);
+    QMenu *changeType = menu.addMenu(m_fontAwesome->faIcon(fa::cogs), "Change type");
+    auto typeMap = AddTypesToMenu(changeType, m_fontAwesome);
+    menu.addSeparator();
+    QAction *moveUp = menu.addAction(m_fontAwesome->faIcon(fa::longarrowup), "Move up");
+    QAction *moveDown = menu.addAction(m_fontAwesome->faIcon(fa::longarrowdown), "Move down");
+    menu.addSeparator();
+    QAction *del = menu.addAction(m_fontAwesome->faIcon(fa::remove), "Delete");
+
+    QAction *act = menu.exec(event->globalPos());
+
+    auto it = typeMap.find(act);
+    if (it != typeMap.end())
+        emit typeChanged(step, it->second);
+    else if (act == moveUp)
+        emit movedUp(step);
+    else if (act == moveDown)
+        emit movedDown(step);
+    else if (act == del)
+        emit deleted(step);
+}
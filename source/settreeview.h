@@ -0,0 +1,72 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef SETTREEVIEW_H
+#define SETTREEVIEW_H
+
+#include <QTreeView>
+#include <QStyledItemDelegate>
+
+#include "types.h"
+#include "ifontawesome.h"
+
+class Step;
+class TurboSetModel;
+
+/*!
+ * Paints a step as a single row: type icon and name, duration, and the description
+ * (or repeat count, for loops). No widgets are created, other than an editor while
+ * a row is being edited.
+ */
+class StepItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    static const int RowHeight = 36;
+
+    explicit StepItemDelegate(IFontAwesome *fontAwesome, QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    QWidget* createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    void setEditorData(QWidget *editor, const QModelIndex &index) const override;
+    void setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const override;
+    void updateEditorGeometry(QWidget *editor, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+protected:
+    QRect editorRect(const QRect &row) const;
+
+protected:
+    IFontAwesome *m_fontAwesome;
+    QFont m_labelFont;
+    QFont m_textFont;
+};
+
+/*!
+ * An alternative to the StagingArea, showing the set as a tree of painted rows.
+ * Rows are only created for expanded loops, and lazily-loaded loops are only parsed
+ * once they are expanded.
+ */
+class SetTreeView : public QTreeView
+{
+    Q_OBJECT
+public:
+    explicit SetTreeView(TurboSetModel *model, IFontAwesome *fontAwesome, QWidget *parent = nullptr);
+
+signals:
+    void deleted(Step *step);
+    void movedUp(Step *step);
+    void movedDown(Step *step);
+    void typeChanged(Step *step, const StepType newType);
+
+protected: // Event handlers
+    void contextMenuEvent(QContextMenuEvent *event) override;
+
+protected:
+    TurboSetModel *m_model;
+    IFontAwesome *m_fontAwesome;
+};
+
+#endif // SETTREEVIEW_H
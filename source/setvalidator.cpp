@@ -0,0 +1,184 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "setvalidator.h"
+#include "step.h"
+#include "turbosetmodel.h"
+#include <algorithm>
+
+static void addIssue(QList<SetIssue> &issues, const SetIssue::Severity severity, const QString &message, const int line = -1)
+{
+    SetIssue issue;
+    issue.severity = severity;
+    issue.message = message;
+    issue.line = line;
+    issues.append(issue);
+}
+
+bool SetValidator::validateDocument(const QDomDocument &doc, QList<SetIssue> &issues)
+{
+    QDomElement root = doc.documentElement();
+    if (root.isNull() || root.tagName() != TurboSetModel::TurboSetTag)
+    {
+        addIssue(issues, SetIssue::Severity::Error, QString("Root element is not <%1>").arg(TurboSetModel::TurboSetTag), root.lineNumber());
+        return false;
+    }
+
+    bool valid = true;
+    for (QDomElement el = root.firstChildElement(); !el.isNull(); el = el.nextSiblingElement())
+    {
+        valid &= validateElement(el, issues);
+    }
+
+    return valid;
+}
+
+bool SetValidator::validateElement(const QDomElement &el, QList<SetIssue> &issues)
+{
+    bool ok = false;
+
+    if (el.tagName().compare(TurboSetModel::IntervalTag, Qt::CaseInsensitive) == 0)
+    {
+        bool valid = true;
+
+        uint type = el.attribute(TurboSetModel::TypeAttr).toUInt(&ok);
+        if (!ok || type >= (uint)StepType::Loop)
+        {
+            addIssue(issues, SetIssue::Severity::Error, "Interval has a missing or unknown type", el.lineNumber());
+            valid = false;
+        }
+
+        el.attribute(TurboSetModel::DurationAttr).toUInt(&ok);
+        if (!ok)
+        {
+            addIssue(issues, SetIssue::Severity::Error, "Interval has a missing or invalid duration", el.lineNumber());
+            valid = false;
+        }
+
+        if (el.attributeNode(TurboSetModel::TextAttr).isNull())
+        {
+            addIssue(issues, SetIssue::Severity::Error, "Interval has no text attribute", el.lineNumber());
+            valid = false;
+        }
+
+        if (!el.firstChildElement().isNull())
+            addIssue(issues, SetIssue::Severity::Warning, "Interval has child elements, these will be ignored", el.lineNumber());
+
+        return valid;
+    }
+
+    if (el.tagName().compare(TurboSetModel::LoopTag, Qt::CaseInsensitive) == 0)
+    {
+        bool valid = true;
+
+        el.attribute(TurboSetModel::IterationsAttr).toUInt(&ok);
+        if (!ok)
+        {
+            addIssue(issues, SetIssue::Severity::Error, "Loop has a missing or invalid iteration count", el.lineNumber());
+            valid = false;
+        }
+
+        for (QDomElement child = el.firstChildElement(); !child.isNull(); child = child.nextSiblingElement())
+        {
+            valid &= validateElement(child, issues);
+        }
+
+        return valid;
+    }
+
+    addIssue(issues, SetIssue::Severity::Warning, QString("Unknown element <%1> will be ignored").arg(el.tagName()), el.lineNumber());
+    return true;
+}
+
+bool SetValidator::validateSteps(const std::vector<Step*> &steps, QList<SetIssue> &issues)
+{
+    if (steps.empty())
+        addIssue(issues, SetIssue::Severity::Warning, "Set is empty");
+
+    bool valid = true;
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+        valid &= validateStep(steps[i], QString::number(i + 1), issues);
+    }
+    return valid;
+}
+
+bool SetValidator::validateStep(const Step *step, const QString &path, QList<SetIssue> &issues)
+{
+    if (!step)
+    {
+        Q_ASSERT(false);
+        return false;
+    }
+
+    if (step->type() != StepType::Loop)
+    {
+        if (step->duration() == 0)
+        {
+            addIssue(issues, SetIssue::Severity::Error, QString("Step %1: interval has zero duration").arg(path));
+            return false;
+        }
+        return true;
+    }
+
+    bool valid = true;
+    const LoopStep *loop = static_cast<const LoopStep*>(step);
+
+    if (loop->iterations() == 0)
+    {
+        addIssue(issues, SetIssue::Severity::Error, QString("Step %1: loop has zero iterations").arg(path));
+        valid = false;
+    }
+
+    size_t children = loop->getChildCount();
+    if (children == 0)
+    {
+        addIssue(issues, SetIssue::Severity::Warning, QString("Step %1: loop is empty").arg(path));
+    }
+
+    for (size_t i = 0; i < children; ++i)
+    {
+        valid &= validateStep(loop->getChild(i), QString("%1.%2").arg(path).arg(i + 1), issues);
+    }
+
+    return valid;
+}
+
+SetStatistics SetValidator::statistics(const std::vector<Step*> &steps)
+{
+    SetStatistics stats;
+    for (auto step : steps)
+    {
+        gatherStatistics(step, 1, 0, stats);
+    }
+    return stats;
+}
+
+void SetValidator::gatherStatistics(const Step *step, quint64 multiplier, size_t depth, SetStatistics &stats)
+{
+    if (!step)
+        return;
+
+    if (step->type() != StepType::Loop)
+    {
+        quint64 seconds = (quint64)step->duration() * multiplier;
+        ++stats.intervals;
+        stats.playedIntervals += multiplier;
+        stats.totalSeconds += seconds;
+        stats.secondsByType[step->type()] += seconds;
+        return;
+    }
+
+    const LoopStep *loop = static_cast<const LoopStep*>(step);
+    ++stats.loops;
+    stats.maxDepth = std::max(stats.maxDepth, depth + 1);
+
+    quint64 iterations = loop->playedIterations();
+
+    size_t children = loop->getChildCount();
+    for (size_t i = 0; i < children; ++i)
+    {
+        gatherStatistics(loop->getChild(i), multiplier * iterations, depth + 1, stats);
+    }
+}
@@ -0,0 +1,80 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef SETVALIDATOR_H
+#define SETVALIDATOR_H
+
+#include <QString>
+#include <QList>
+#include <QtXml/QDomDocument>
+#include <map>
+#include <vector>
+#include "types.h"
+
+class Step;
+
+/*! A single problem found while validating a set */
+struct SetIssue
+{
+    enum class Severity
+    {
+        Warning,
+        Error
+    };
+
+    Severity severity;
+    QString message;
+    int line; //!< Line in the source file, or -1 if unknown.
+};
+
+/*! Summary figures for a set, with loops expanded by their iteration count */
+struct SetStatistics
+{
+    SetStatistics()
+        : intervals(0)
+        , loops(0)
+        , maxDepth(0)
+        , playedIntervals(0)
+        , totalSeconds(0)
+    {
+    }
+
+    size_t intervals;           //!< Number of interval steps in the set, as edited.
+    size_t loops;               //!< Number of loop steps in the set.
+    size_t maxDepth;            //!< Deepest level of loop nesting.
+    quint64 playedIntervals;    //!< Number of intervals played back, loops expanded.
+    quint64 totalSeconds;       //!< Playback duration, loops expanded.
+    std::map<StepType, quint64> secondsByType;
+};
+
+/*! Checks sets for structural and semantic problems and gathers statistics on them */
+class SetValidator
+{
+public:
+    /*!
+     * Check the raw XML of a set against the structure TurboSetModel expects.
+     * \param doc The parsed document.
+     * \param issues Receives any problems found.
+     * \return false if the document has errors that would cause steps to be dropped on load.
+     */
+    static bool validateDocument(const QDomDocument &doc, QList<SetIssue> &issues);
+
+    /*!
+     * Check a loaded set for steps that are valid XML but make no sense to play back.
+     * \param steps The top-level steps of the set.
+     * \param issues Receives any problems found.
+     * \return false if any errors were found.
+     */
+    static bool validateSteps(const std::vector<Step*> &steps, QList<SetIssue> &issues);
+
+    //! Gather statistics on a loaded set.
+    static SetStatistics statistics(const std::vector<Step*> &steps);
+
+protected:
+    static bool validateElement(const QDomElement &el, QList<SetIssue> &issues);
+    static bool validateStep(const Step *step, const QString &path, QList<SetIssue> &issues);
+    static void gatherStatistics(const Step *step, quint64 multiplier, size_t depth, SetStatistics &stats);
+};
+
+#endif // SETVALIDATOR_H
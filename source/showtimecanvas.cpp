@@ -0,0 +1,387 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "showtimecanvas.h"
+#include "step.h"
+#include "stepresources.h"
+#include "fontfitcache.h"
+#include "framescheduler.h"
+#include <QPainter>
+#include <QPaintEvent>
+
+static const int MarginWidth    = 30;   // Around and between the panels
+static const int Margin         = 5;    // Inside the panels
+static const int TimeMargin     = 15;
+static const int TextLines      = 3;    // Descriptions are sized to fit this many lines
+static const QColor BackgroundColour(0xff, 0xff, 0xff);
+static const QColor PanelColour(0xa0, 0xa0, 0xa0);
+static const QColor BorderColour(0x33, 0x33, 0x33);
+static const QColor CountdownColour(0xa9, 0xda, 0x88);
+static const QColor SetProgressColour(0x88, 0xb4, 0xda);
+static const QColor StatusColour(200, 200, 200, 100);
+
+static QStaticText PlainText(const QString &text)
+{
+    QStaticText staticText(text);
+    staticText.setTextFormat(Qt::PlainText);
+    return staticText;
+}
+
+static QString FormatDuration(const uint seconds)
+{
+    return QString("%1:%2:%3").arg(seconds / 3600, 2, 10, QChar('0')).arg((seconds / 60) % 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+ShowTimeCanvas::Assets::Assets()
+    : countdown(QFont(FontName, 18, QFont::Bold), CountdownColour)
+    , progress(CountdownColour, SetProgressColour)
+{
+    layout.nowHeaderFont = QFont(FontName, 18, QFont::Bold);
+    layout.nowTextFont = QFont(FontName, 12, QFont::Bold);
+    layout.upHeaderFont = QFont(FontName, 12, QFont::Bold);
+    layout.upTextFont = QFont(FontName, 9, QFont::Bold);
+}
+
+ShowTimeCanvas::ShowTimeCanvas(IFontAwesome *fontAwesome, QWidget *parent, const Variant variant)
+    : QWidget(parent)
+    , m_fontAwesome(fontAwesome)
+    , m_variant(variant)
+    , m_nowPlaying(nullptr)
+    , m_upNext(nullptr)
+    , m_countdownText(CountdownAtlas::format(0))
+    , m_intervalProgress(0)
+    , m_setProgress(0)
+    , m_statusFont(FontName, 18, QFont::Bold)
+    , m_upLabel(PlainText("Up next:"))
+    , m_statusVisible(false)
+{
+    Q_ASSERT(fontAwesome);
+
+    // Everything is painted here, so there's nothing underneath to clear first.
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    updateLayout();
+}
+
+void ShowTimeCanvas::setNowPlaying(Interval *nowPlaying)
+{
+    m_nowPlaying = nowPlaying;
+    m_nowType = PlainText(nowPlaying ? TypeToString(nowPlaying->type()) : QString());
+    m_nowText = PlainText(nowPlaying ? nowPlaying->text() : QString());
+    prepareText();
+
+    FrameScheduler::instance().schedule(this, m_assets->layout.nowPlaying);
+}
+
+void ShowTimeCanvas::setIterations(const bool loop, const uint32_t currentIteration, const uint32_t totalIterations)
+{
+    QString text = loop ? QString("Loop %1/%2").arg(currentIteration).arg(totalIterations) : QString();
+    if (text == m_iteration.text())
+        return;
+
+    m_iteration = PlainText(text);
+    prepareText();
+
+    FrameScheduler::instance().schedule(this, m_assets->layout.iteration);
+}
+
+void ShowTimeCanvas::setTimeRemaining(const uint secondsRemaining)
+{
+    QString text = CountdownAtlas::format(secondsRemaining);
+    if (text == m_countdownText)
+        return;
+
+    QRect changed = m_assets->countdown.changedRect(m_countdownText, text);
+    m_countdownText = text;
+    FrameScheduler::instance().schedule(this, changed.translated(m_assets->layout.countdown.topLeft()));
+}
+
+void ShowTimeCanvas::setProgress(const qreal interval, const qreal set)
+{
+    const ProgressBars &bars = m_assets->progress;
+    QRect changed = bars.changedRect(bars.edge(m_intervalProgress), bars.edge(m_setProgress), bars.edge(interval), bars.edge(set));
+    m_intervalProgress = interval;
+    m_setProgress = set;
+
+    // Most frames the bars haven't moved a whole device pixel, so there's nothing to paint.
+    if (!changed.isEmpty())
+        FrameScheduler::instance().schedule(this, changed.translated(m_assets->layout.progress.topLeft()));
+}
+
+void ShowTimeCanvas::setUpNext(Interval *upNext)
+{
+    m_upNext = upNext;
+    m_upType = PlainText(upNext ? TypeToString(upNext->type()) : QString());
+    m_upTime = PlainText(upNext ? FormatDuration(upNext->duration()) : QString());
+    m_upText = PlainText(upNext ? upNext->text() : QString());
+    prepareText();
+
+    FrameScheduler::instance().schedule(this, m_assets->layout.upNext);
+}
+
+void ShowTimeCanvas::showStatus(const QString &status)
+{
+    m_status = PlainText(status);
+    m_statusVisible = true;
+
+    // The status font is fitted to the text's width.
+    m_statusFont.setPointSizeF(FontFitCache::fitWidth(m_statusFont, status, m_assets->layout.status.width()));
+    prepareText();
+
+    FrameScheduler::instance().schedule(this, m_assets->layout.status);
+}
+
+void ShowTimeCanvas::hideStatus()
+{
+    if (!m_statusVisible)
+        return;
+
+    m_statusVisible = false;
+    FrameScheduler::instance().schedule(this, m_assets->layout.status);
+}
+
+void ShowTimeCanvas::resizeEvent(QResizeEvent *event)
+{
+    Q_UNUSED(event);
+    updateLayout();
+    update();
+}
+
+void ShowTimeCanvas::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    const QRect area = event->rect();
+    const Layout &layout = m_assets->layout;
+
+    painter.fillRect(area, BackgroundColour);
+
+    // A tick only touches the countdown, so everything else is skipped unless it's in the area.
+    if (m_nowPlaying && area.intersects(layout.nowPlaying))
+    {
+        paintPanel(painter, layout.nowPlaying, layout.nowHeader, m_nowPlaying);
+
+        if (area.intersects(layout.nowHeader))
+        {
+            paintIcon(painter, layout.nowIcon, m_nowPlaying);
+
+            painter.setFont(layout.nowHeaderFont);
+            paintText(painter, layout.nowType, m_nowType, Qt::AlignCenter);
+            paintText(painter, layout.iteration, m_iteration, Qt::AlignRight | Qt::AlignVCenter);
+        }
+
+        if (area.intersects(layout.countdown))
+            m_assets->countdown.paint(painter, layout.countdown.topLeft(), m_countdownText, area);
+
+        if (area.intersects(layout.progress))
+            m_assets->progress.paint(painter, layout.progress.topLeft(), m_assets->progress.edge(m_intervalProgress), m_assets->progress.edge(m_setProgress), area);
+
+        if (area.intersects(layout.nowText))
+        {
+            painter.setFont(layout.nowTextFont);
+            paintText(painter, layout.nowText, m_nowText, Qt::AlignLeft | Qt::AlignBottom);
+        }
+    }
+
+    if (m_upNext && area.intersects(layout.upNext))
+    {
+        paintPanel(painter, layout.upNext, layout.upHeader, m_upNext);
+
+        if (area.intersects(layout.upHeader))
+        {
+            paintIcon(painter, layout.upIcon, m_upNext);
+
+            painter.setFont(layout.upHeaderFont);
+            paintText(painter, layout.upLabel, m_upLabel, Qt::AlignLeft | Qt::AlignVCenter);
+            paintText(painter, layout.upType, m_upType, Qt::AlignCenter);
+            paintText(painter, layout.upTime, m_upTime, Qt::AlignRight | Qt::AlignVCenter);
+        }
+
+        if (area.intersects(layout.upText))
+        {
+            painter.setFont(layout.upTextFont);
+            paintText(painter, layout.upText, m_upText, Qt::AlignLeft | Qt::AlignTop);
+        }
+    }
+
+    if (m_statusVisible && area.intersects(layout.status))
+    {
+        painter.fillRect(layout.status, StatusColour);
+        painter.setFont(m_statusFont);
+        paintText(painter, layout.status, m_status, Qt::AlignCenter);
+    }
+}
+
+void ShowTimeCanvas::updateLayout()
+{
+    m_assets = sharedAssets(size(), devicePixelRatioF(), m_variant);
+
+    if (m_statusVisible)
+        m_statusFont.setPointSizeF(FontFitCache::fitWidth(m_statusFont, m_status.text(), m_assets->layout.status.width()));
+
+    prepareText();
+}
+
+QSharedPointer<const ShowTimeCanvas::Assets> ShowTimeCanvas::sharedAssets(const QSize &size, const qreal pixelRatio, const Variant variant)
+{
+    // Held weakly, so the assets go when the last canvas using them is resized or closed.
+    static QHash<QString, QWeakPointer<const Assets> > cache;
+
+    QString key = QString("%1x%2@%3/%4").arg(size.width()).arg(size.height()).arg(pixelRatio).arg((int)variant);
+    QSharedPointer<const Assets> shared = cache.value(key).toStrongRef();
+    if (shared)
+        return shared;
+
+    QSharedPointer<Assets> assets(new Assets);
+    computeLayout(assets->layout, size, variant);
+    assets->countdown.resize(assets->layout.countdown.size(), pixelRatio);
+    assets->progress.resize(assets->layout.progress.size(), pixelRatio);
+
+    for (auto it = cache.begin(); it != cache.end(); )
+    {
+        it = it.value().isNull() ? cache.erase(it) : it + 1;
+    }
+    cache.insert(key, assets);
+
+    return assets;
+}
+
+void ShowTimeCanvas::computeLayout(Layout &layout, const QSize &size, const Variant variant)
+{
+    const int width = size.width();
+    const int height = size.height();
+    int panelWidth = width - (MarginWidth * 2);
+
+    float vMargin = height / 5.0f;
+    float hMargin = width / 5.0f;
+    layout.status = QRect(hMargin, vMargin, width - (hMargin * 2), height - (vMargin * 2));
+
+    if (variant == Variant::Countdown)
+    {
+        // Just the header and the countdown, filling the screen.
+        layout.nowPlaying = QRect(MarginWidth, MarginWidth, panelWidth, height - (MarginWidth * 2));
+        layout.nowHeader = QRect(layout.nowPlaying.topLeft(), QSize(panelWidth, layout.nowPlaying.height() / 8));
+    }
+    else
+    {
+        // Now playing takes three quarters of the height, up next the rest.
+        int topHeight = ((height * 3) / 4) - (MarginWidth * 2);
+        layout.nowPlaying = QRect(MarginWidth, MarginWidth, panelWidth, topHeight);
+        layout.upNext = QRect(MarginWidth, topHeight + (MarginWidth * 2), panelWidth, height - topHeight - (MarginWidth * 3));
+        layout.nowHeader = QRect(layout.nowPlaying.left(), layout.nowPlaying.top(), panelWidth, layout.nowPlaying.height() / 5);
+    }
+
+    // Now playing: a header of icon, type and iteration, then the countdown, progress and the description.
+    QRect now = layout.nowPlaying;
+
+    QRect header = layout.nowHeader.adjusted(Margin, Margin, -Margin, -Margin);
+    layout.nowIcon = QRect(header.left(), header.top(), header.height(), header.height());
+    layout.iteration = QRect(header.left() + (header.width() * 2) / 3, header.top(), header.width() / 3, header.height());
+    layout.nowType = QRect(layout.nowIcon.right() + Margin, header.top(), layout.iteration.left() - layout.nowIcon.right() - (Margin * 2), header.height());
+
+    int bodyHeight = now.height() - layout.nowHeader.height();
+    int progressHeight = bodyHeight / 8;
+
+    if (variant == Variant::Countdown)
+    {
+        layout.countdown = QRect(now.left() + Margin, layout.nowHeader.bottom() + 1 + TimeMargin, now.width() - (Margin * 2), bodyHeight - progressHeight - (TimeMargin * 3));
+        layout.progress = QRect(now.left() + Margin, layout.countdown.bottom() + 1 + TimeMargin, now.width() - (Margin * 2), progressHeight);
+        layout.nowText = QRect();
+    }
+    else
+    {
+        layout.countdown = QRect(now.left() + Margin, layout.nowHeader.bottom() + 1, now.width() - (Margin * 2), (bodyHeight * 3) / 5);
+        layout.progress = QRect(now.left() + Margin, layout.countdown.bottom() + 1, now.width() - (Margin * 2), progressHeight);
+        layout.nowText = QRect(now.left() + Margin, layout.progress.bottom() + TimeMargin, now.width() - (Margin * 2), now.bottom() - layout.progress.bottom() - (TimeMargin * 2));
+    }
+
+    // Fonts are fitted once per size, not per paint.
+    layout.nowHeaderFont.setPointSizeF(FontFitCache::fitHeight(layout.nowHeaderFont, layout.nowType.height()));
+    layout.nowTextFont.setPointSizeF(FontFitCache::fitHeight(layout.nowTextFont, layout.nowText.height() / TextLines));
+
+    if (variant == Variant::Countdown)
+    {
+        layout.upNext = layout.upHeader = layout.upLabel = layout.upIcon = layout.upType = layout.upTime = layout.upText = QRect();
+        return;
+    }
+
+    // Up next: a header of label, icon, type and duration, then the description.
+    QRect up = layout.upNext;
+    layout.upHeader = QRect(up.left(), up.top(), up.width(), up.height() / 2);
+
+    header = layout.upHeader.adjusted(Margin, Margin, -Margin, -Margin);
+    int quarter = header.width() / 4;
+    layout.upLabel = QRect(header.left(), header.top(), quarter, header.height());
+    layout.upIcon = QRect(layout.upLabel.right() + Margin, header.top(), header.height(), header.height());
+    layout.upTime = QRect(header.right() - quarter, header.top(), quarter, header.height());
+    layout.upType = QRect(layout.upIcon.right() + Margin, header.top(), layout.upTime.left() - layout.upIcon.right() - (Margin * 2), header.height());
+    layout.upText = QRect(up.left() + Margin, layout.upHeader.bottom() + (Margin * 2), up.width() - (Margin * 2), up.bottom() - layout.upHeader.bottom() - (Margin * 3));
+
+    layout.upHeaderFont.setPointSizeF(FontFitCache::fitHeight(layout.upHeaderFont, layout.upType.height()));
+    layout.upTextFont.setPointSizeF(FontFitCache::fitHeight(layout.upTextFont, layout.upText.height() / TextLines));
+}
+
+void ShowTimeCanvas::prepareText()
+{
+    const Layout &layout = m_assets->layout;
+
+    // Lay the text out now, so that painting it is just drawing the glyphs.
+    m_nowText.setTextWidth(layout.nowText.width());
+    m_upText.setTextWidth(layout.upText.width());
+
+    m_nowType.prepare(QTransform(), layout.nowHeaderFont);
+    m_iteration.prepare(QTransform(), layout.nowHeaderFont);
+    m_nowText.prepare(QTransform(), layout.nowTextFont);
+    m_upLabel.prepare(QTransform(), layout.upHeaderFont);
+    m_upType.prepare(QTransform(), layout.upHeaderFont);
+    m_upTime.prepare(QTransform(), layout.upHeaderFont);
+    m_upText.prepare(QTransform(), layout.upTextFont);
+    m_status.prepare(QTransform(), m_statusFont);
+}
+
+void ShowTimeCanvas::paintPanel(QPainter &painter, const QRect &panel, const QRect &header, Interval *interval)
+{
+    painter.setPen(BorderColour);
+    painter.setBrush(Qt::NoBrush);
+
+    QRect headerRect = header.adjusted(0, 0, -1, 0);
+    painter.fillRect(headerRect, TypeToBgColour(interval->type()));
+    painter.drawRect(headerRect);
+
+    QRect bodyRect(panel.left(), header.bottom() + 1, panel.width() - 1, panel.bottom() - header.bottom() - 1);
+    painter.fillRect(bodyRect, PanelColour);
+    painter.drawRect(bodyRect);
+}
+
+void ShowTimeCanvas::paintIcon(QPainter &painter, const QRect &rect, Interval *interval)
+{
+    painter.setFont(m_fontAwesome->faFont(rect.height()));
+    painter.setPen(Qt::black);
+    painter.drawText(rect, Qt::AlignCenter, QString(QChar(TypeToFaIcon(interval->type()))));
+}
+
+void ShowTimeCanvas::paintText(QPainter &painter, const QRect &rect, const QStaticText &text, const Qt::Alignment alignment)
+{
+    if (text.text().isEmpty())
+        return;
+
+    QSizeF size = text.size();
+    qreal x = rect.left();
+    qreal y = rect.top();
+
+    if (alignment & Qt::AlignRight)
+        x = rect.right() + 1 - size.width();
+    else if (alignment & Qt::AlignHCenter)
+        x = rect.left() + (rect.width() - size.width()) / 2;
+
+    if (alignment & Qt::AlignBottom)
+        y = rect.bottom() + 1 - size.height();
+    else if (alignment & Qt::AlignVCenter)
+        y = rect.top() + (rect.height() - size.height()) / 2;
+
+    painter.setPen(Qt::black);
+    painter.save();
+    painter.setClipRect(rect, Qt::IntersectClip);
+    painter.drawStaticText(QPointF(x, y), text);
+    painter.restore();
+}
@@ -0,0 +1,126 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef SHOWTIMECANVAS_H
+#define SHOWTIMECANVAS_H
+
+#include <QWidget>
+#include <QFont>
+#include <QStaticText>
+#include <QSharedPointer>
+#include "countdownwidget.h"
+#include "progressbars.h"
+#include "ifontawesome.h"
+
+class Interval;
+
+/*!
+ * Draws the whole show-time frame (now playing, up next and any status message) in a
+ * single paint, as an alternative to the tree of widgets and labels.
+ *
+ * The position and font of every element is worked out when the canvas is resized and
+ * the text is laid out when it's set, so painting only draws. Changes only repaint the
+ * area they affect, so a tick of the countdown repaints just the digits that changed and
+ * a step of the progress bars just the strips they've moved across.
+ *
+ * Several canvases can show the same set, e.g. mirrored on several screens. Layouts and
+ * countdown atlases are shared between all the canvases of the same size and variant,
+ * so another screen of the same kind costs no more layout or font rasterising.
+ */
+class ShowTimeCanvas : public QWidget
+{
+    Q_OBJECT
+public:
+    enum class Variant
+    {
+        Full,           //!< Now playing and up next
+        Countdown       //!< Just the current interval's header and its countdown, as large as possible
+    };
+
+    explicit ShowTimeCanvas(IFontAwesome *fontAwesome, QWidget *parent = nullptr, const Variant variant = Variant::Full);
+
+    void setNowPlaying(Interval *nowPlaying);
+    void setIterations(const bool loop, const uint32_t currentIteration, const uint32_t totalIterations);
+    void setTimeRemaining(const uint secondsRemaining);
+    void setProgress(const qreal interval, const qreal set);
+    void setUpNext(Interval *upNext);
+
+    void showStatus(const QString &status);
+    void hideStatus();
+
+protected: // Event handlers
+    void resizeEvent(QResizeEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+
+protected:
+    /*! Where everything goes, recomputed when the canvas is resized */
+    struct Layout
+    {
+        QRect nowPlaying;
+        QRect nowHeader;
+        QRect nowIcon;
+        QRect nowType;
+        QRect iteration;
+        QRect countdown;
+        QRect progress;
+        QRect nowText;
+
+        QRect upNext;
+        QRect upHeader;
+        QRect upLabel;
+        QRect upIcon;
+        QRect upType;
+        QRect upTime;
+        QRect upText;
+
+        QRect status;
+
+        QFont nowHeaderFont;
+        QFont nowTextFont;
+        QFont upHeaderFont;
+        QFont upTextFont;
+    };
+
+    /*! Everything worked out for a given size, shared between canvases */
+    struct Assets
+    {
+        Assets();
+
+        Layout layout;
+        CountdownAtlas countdown;
+        ProgressBars progress;
+    };
+
+    static QSharedPointer<const Assets> sharedAssets(const QSize &size, const qreal pixelRatio, const Variant variant);
+    static void computeLayout(Layout &layout, const QSize &size, const Variant variant);
+
+    void updateLayout();
+    void prepareText();
+    void paintPanel(QPainter &painter, const QRect &panel, const QRect &header, Interval *interval);
+    void paintIcon(QPainter &painter, const QRect &rect, Interval *interval);
+    void paintText(QPainter &painter, const QRect &rect, const QStaticText &text, const Qt::Alignment alignment);
+
+protected:
+    IFontAwesome    *m_fontAwesome;
+    Variant         m_variant;
+    Interval        *m_nowPlaying;
+    Interval        *m_upNext;
+    QSharedPointer<const Assets> m_assets;
+    QString         m_countdownText;
+    qreal           m_intervalProgress;
+    qreal           m_setProgress;
+    QFont           m_statusFont;
+
+    QStaticText     m_nowType;
+    QStaticText     m_iteration;
+    QStaticText     m_nowText;
+    QStaticText     m_upLabel;
+    QStaticText     m_upType;
+    QStaticText     m_upTime;
+    QStaticText     m_upText;
+    QStaticText     m_status;
+    bool            m_statusVisible;
+};
+
+#endif // SHOWTIMECANVAS_H
@@ -8,9 +8,12 @@
 #include "stepresources.h"
 #include <QPainter>
 #include <QTimer>
+#include <QTimerEvent>
+#include <algorithm>
 
 static const int TimerInterval  = 1000; // 1 second;
 static const int MarginWidth    = 30;
+static const int DefaultProgressFrameRate = 30;
 
 ShowTimeWindow::ShowTimeWindow(QWidget *parent)
     : QWidget(parent, Qt::Window)
@@ -44,27 +47,47 @@ void ShowTimeWindow::adjustLayout()
 }
 
 
-ShowTimeWidget::ShowTimeWidget(ISetManager *setManager, IFontAwesome *fontAwesome, QWidget *parent)
+ShowTimeWidget::ShowTimeWidget(ISetManager *setManager, IFontAwesome *fontAwesome, QWidget *parent, const Renderer renderer)
     : QWidget(parent)
     , m_setManager(setManager)
     , m_fontAwesome(fontAwesome)
+    , m_canvas(nullptr)
     , m_nowPlaying(nullptr)
     , m_upNext(nullptr)
     , m_status(nullptr)
+    , m_current(nullptr)
+    , m_next(nullptr)
+    , m_loop(false)
+    , m_currentIteration(0)
+    , m_totalIterations(0)
+    , m_statusVisible(false)
     , m_secsRemaining(0)
+    , m_intervalProgress(0)
+    , m_setProgress(0)
     , m_running(false)
     , m_timerId(-1)
+    , m_progressTimerId(-1)
+    , m_progressFrameRate(DefaultProgressFrameRate)
 {
     Q_ASSERT(setManager && fontAwesome);
 
-    m_nowPlaying = new NowPlayingWidget(m_fontAwesome, this);
-    m_nowPlaying->show();
+    if (renderer == Renderer::Canvas)
+    {
+        m_canvas = new ShowTimeCanvas(m_fontAwesome, this);
+        m_canvas->show();
+        m_canvases.append(m_canvas);
+    }
+    else
+    {
+        m_nowPlaying = new NowPlayingWidget(m_fontAwesome, this);
+        m_nowPlaying->show();
 
-    m_upNext = new UpNextWidget(m_fontAwesome, this);
-    m_upNext->show();
+        m_upNext = new UpNextWidget(m_fontAwesome, this);
+        m_upNext->show();
 
-    m_status = new QLabel(this);
-    m_status->hide();
+        m_status = new QLabel(this);
+        m_status->hide();
+    }
 
     setFocusPolicy(Qt::StrongFocus);
 
@@ -96,34 +119,106 @@ void ShowTimeWidget::keyPressEvent(QKeyEvent *event)
 
 void ShowTimeWidget::onIntervalStarted()
 {
-    if (!m_setManager || !m_setManager->currentInterval() || !m_nowPlaying || !m_upNext)
+    if (!m_setManager || !m_setManager->currentInterval())
+        return;
+
+    m_current = m_setManager->currentInterval();
+    m_next = m_setManager->nextInterval();
+    m_secsRemaining = m_current->duration();
+    m_loop = m_setManager->currentIteration(m_currentIteration, m_totalIterations);
+    m_statusVisible = false;
+
+    PlaybackProgress progress;
+    if (m_setManager->playbackProgress(progress) && progress.setDuration > 0)
+        m_setProgress = (qreal)progress.setElapsed / progress.setDuration;
+    m_intervalProgress = 0;
+
+    for (ShowTimeCanvas *canvas : m_canvases)
+    {
+        syncCanvas(canvas);
+    }
+
+    if (!m_nowPlaying || !m_upNext)
         return;
 
     if (m_status)
         m_status->hide();
 
-    Interval *current = m_setManager->currentInterval();
-    m_nowPlaying->setInterval(current);
-    m_secsRemaining = current->duration();
+    m_nowPlaying->setInterval(m_current);
     m_nowPlaying->setTimeRemaining(m_secsRemaining);
+    m_nowPlaying->setIterations(m_loop, m_currentIteration, m_totalIterations);
+    m_nowPlaying->setProgress(m_intervalProgress, m_setProgress);
+
+    m_upNext->setInterval(m_next);
+}
+
+void ShowTimeWidget::addMirror(ShowTimeCanvas *canvas)
+{
+    if (!canvas || m_canvases.contains(canvas))
+    {
+        Q_ASSERT(false);
+        return;
+    }
 
-    uint32_t currentIteration = 0, totalIterations = 0;
-    bool loop = m_setManager->currentIteration(currentIteration, totalIterations);
-    m_nowPlaying->setIterations(loop, currentIteration, totalIterations);
+    m_canvases.append(canvas);
+    QObject::connect(canvas, SIGNAL(destroyed(QObject*)), this, SLOT(onMirrorDestroyed(QObject*)));
 
-    m_upNext->setInterval(m_setManager->nextInterval());
+    // Catch up with whatever's already showing.
+    syncCanvas(canvas);
+}
+
+void ShowTimeWidget::removeMirror(ShowTimeCanvas *canvas)
+{
+    if (canvas == m_canvas)
+    {
+        Q_ASSERT(false);
+        return;
+    }
+
+    QObject::disconnect(canvas, SIGNAL(destroyed(QObject*)), this, SLOT(onMirrorDestroyed(QObject*)));
+    m_canvases.removeAll(canvas);
+}
+
+void ShowTimeWidget::onMirrorDestroyed(QObject *canvas)
+{
+    // Only the address is used, the canvas is already partly destroyed.
+    m_canvases.removeAll(static_cast<ShowTimeCanvas*>(canvas));
+}
+
+void ShowTimeWidget::setProgressFrameRate(const int framesPerSecond)
+{
+    m_progressFrameRate = std::max(framesPerSecond, 0);
+
+    if (m_running)
+        startProgress();
+}
+
+void ShowTimeWidget::syncCanvas(ShowTimeCanvas *canvas)
+{
+    canvas->setNowPlaying(m_current);
+    canvas->setTimeRemaining(m_secsRemaining);
+    canvas->setProgress(m_intervalProgress, m_setProgress);
+    canvas->setIterations(m_loop, m_currentIteration, m_totalIterations);
+    canvas->setUpNext(m_next);
+
+    if (m_statusVisible)
+        canvas->showStatus(m_statusText);
+    else
+        canvas->hideStatus();
 }
 
 void ShowTimeWidget::onSetStarted()
 {
     m_running = true;
     m_timerId = startTimer(TimerInterval);
+    startProgress();
 }
 
 void ShowTimeWidget::onSetPaused()
 {
     m_running = false;
     killTimer(m_timerId);
+    stopProgress();
     showStatus("-Paused-", false);
 }
 
@@ -131,6 +226,7 @@ void ShowTimeWidget::onSetResumed()
 {
     m_running = true;
     m_timerId = startTimer(TimerInterval);
+    startProgress();
     showStatus("-Resumed-", true);
 }
 
@@ -142,6 +238,11 @@ void ShowTimeWidget::onSetComplete()
         killTimer(m_timerId);
         m_timerId = -1;
     }
+    stopProgress();
+
+    m_intervalProgress = 1;
+    m_setProgress = 1;
+    showProgress();
 
     showStatus("Set Complete", false);
 }
@@ -154,6 +255,7 @@ void ShowTimeWidget::onSetStopped()
         killTimer(m_timerId);
         m_timerId = -1;
     }
+    stopProgress();
 }
 
 void ShowTimeWidget::onPlaybackError(const QString &error)
@@ -164,19 +266,78 @@ void ShowTimeWidget::onPlaybackError(const QString &error)
         killTimer(m_timerId);
         m_timerId = -1;
     }
+    stopProgress();
 
     showStatus(error, false);
 }
 
 void ShowTimeWidget::timerEvent(QTimerEvent *event)
 {
-    Q_UNUSED(event);
+    if (event->timerId() == m_progressTimerId)
+    {
+        updateProgress();
+        return;
+    }
 
-    if (m_nowPlaying && (m_secsRemaining > 0))
+    if (m_secsRemaining > 0)
     {
         --m_secsRemaining;
-        m_nowPlaying->setTimeRemaining(m_secsRemaining);
+        setTimeRemaining(m_secsRemaining);
+    }
+}
+
+void ShowTimeWidget::setTimeRemaining(const uint secondsRemaining)
+{
+    for (ShowTimeCanvas *canvas : m_canvases)
+    {
+        canvas->setTimeRemaining(secondsRemaining);
+    }
+
+    if (m_nowPlaying)
+        m_nowPlaying->setTimeRemaining(secondsRemaining);
+}
+
+void ShowTimeWidget::updateProgress()
+{
+    // Read from the playback clock, so the bars can't drift from the set's own timing.
+    PlaybackProgress progress;
+    if (!m_setManager->playbackProgress(progress))
+        return;
+
+    m_intervalProgress = (progress.intervalDuration > 0) ? (qreal)progress.intervalElapsed / progress.intervalDuration : 0;
+    m_setProgress = (progress.setDuration > 0) ? (qreal)progress.setElapsed / progress.setDuration : 0;
+    showProgress();
+}
+
+void ShowTimeWidget::showProgress()
+{
+    for (ShowTimeCanvas *canvas : m_canvases)
+    {
+        canvas->setProgress(m_intervalProgress, m_setProgress);
+    }
+
+    if (m_nowPlaying)
+        m_nowPlaying->setProgress(m_intervalProgress, m_setProgress);
+}
+
+void ShowTimeWidget::startProgress()
+{
+    stopProgress();
+
+    if (m_progressFrameRate > 0)
+        m_progressTimerId = startTimer(1000 / m_progressFrameRate, Qt::PreciseTimer);
+}
+
+void ShowTimeWidget::stopProgress()
+{
+    if (m_progressTimerId > 0)
+    {
+        killTimer(m_progressTimerId);
+        m_progressTimerId = -1;
     }
+
+    // Leave the bars exactly where playback stopped.
+    updateProgress();
 }
 
 void ShowTimeWidget::resizeEvent(QResizeEvent *event)
@@ -193,6 +354,15 @@ void ShowTimeWidget::mouseDoubleClickEvent(QMouseEvent *event)
 
 void ShowTimeWidget::onHideStatus()
 {
+    m_statusVisible = false;
+    for (ShowTimeCanvas *canvas : m_canvases)
+    {
+        canvas->hideStatus();
+    }
+
+    if (m_canvas)
+        return;
+
     if (!m_status)
     {
         Q_ASSERT(false);
@@ -204,6 +374,12 @@ void ShowTimeWidget::onHideStatus()
 
 void ShowTimeWidget::adjustLayout()
 {
+    if (m_canvas)
+    {
+        m_canvas->setGeometry(rect());
+        return;
+    }
+
     if (!m_nowPlaying || !m_upNext)
     {
         Q_ASSERT(false);
@@ -226,19 +402,29 @@ void ShowTimeWidget::adjustLayout()
 
 void ShowTimeWidget::showStatus(const QString &statusMsg, bool autoHide)
 {
-    if (!m_status)
+    m_statusText = statusMsg;
+    m_statusVisible = true;
+    for (ShowTimeCanvas *canvas : m_canvases)
     {
-        Q_ASSERT(false);
-        return;
+        canvas->showStatus(statusMsg);
     }
 
-    m_status->show();
-    m_status->raise();
-    m_status->setText(statusMsg);
-    m_status->setStyleSheet("background-color: rgba(200, 200, 200, 100);");
-    m_status->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
-
-    adjustLayout();
+    if (!m_canvas)
+    {
+        if (!m_status)
+        {
+            Q_ASSERT(false);
+            return;
+        }
+
+        m_status->show();
+        m_status->raise();
+        m_status->setText(statusMsg);
+        m_status->setStyleSheet("background-color: rgba(200, 200, 200, 100);");
+        m_status->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
+
+        adjustLayout();
+    }
 
     if (autoHide)
         QTimer::singleShot(1000, this, SLOT(onHideStatus()));
@@ -14,6 +14,7 @@
 #include <QKeyEvent>
 #include "nowplayingwidget.h"
 #include "upnextwidget.h"
+#include "showtimecanvas.h"
 #include "ifontawesome.h"
 
 class ISetManager;
@@ -38,12 +39,30 @@ protected:
     QWidget *m_widget;
 };
 
-/*! Widget used for displaying the set when it's running */
+/*!
+ * Widget used for displaying the set when it's running.
+ * The frame is either drawn by a ShowTimeCanvas in a single paint, or built from the
+ * NowPlayingWidget/UpNextWidget widget trees. Mirrors (canvases shown elsewhere, e.g. on
+ * other screens) are driven from the same state and timer.
+ */
 class ShowTimeWidget : public QWidget
 {
     Q_OBJECT
 public:
-    explicit ShowTimeWidget(ISetManager *setManager, IFontAwesome *fontAwesome, QWidget *parent = nullptr);
+    enum class Renderer
+    {
+        Canvas,
+        Widgets
+    };
+
+    explicit ShowTimeWidget(ISetManager *setManager, IFontAwesome *fontAwesome, QWidget *parent = nullptr, const Renderer renderer = Renderer::Canvas);
+
+    //! Show the set on another canvas as well. The canvas is removed automatically when destroyed.
+    void addMirror(ShowTimeCanvas *canvas);
+    void removeMirror(ShowTimeCanvas *canvas);
+
+    //! Limit how often the progress bars are moved, 0 only moves them at the start of each interval.
+    void setProgressFrameRate(const int framesPerSecond);
 
 signals:
     void toggleFullscreen();
@@ -68,20 +87,40 @@ protected: // Event handlers
 
 protected slots:
     void onHideStatus();
+    void onMirrorDestroyed(QObject *canvas);
 
 protected:
     void adjustLayout();
     void showStatus(const QString &statusMsg, bool autoHide);
+    void setTimeRemaining(const uint secondsRemaining);
+    void updateProgress();
+    void showProgress();
+    void startProgress();
+    void stopProgress();
+    void syncCanvas(ShowTimeCanvas *canvas);
 
 protected:
     ISetManager         *m_setManager;
     IFontAwesome        *m_fontAwesome;
+    ShowTimeCanvas      *m_canvas;
+    QList<ShowTimeCanvas*> m_canvases;      //!< Our own canvas, if any, and the mirrors.
     NowPlayingWidget    *m_nowPlaying;
     UpNextWidget        *m_upNext;
     QLabel              *m_status;
+    Interval            *m_current;
+    Interval            *m_next;
+    bool                m_loop;
+    uint32_t            m_currentIteration;
+    uint32_t            m_totalIterations;
+    QString             m_statusText;
+    bool                m_statusVisible;
     uint                m_secsRemaining;
+    qreal               m_intervalProgress;
+    qreal               m_setProgress;
     bool                m_running;
     int                 m_timerId;
+    int                 m_progressTimerId;
+    int                 m_progressFrameRate;
 };
 
 #endif // SHOWTIMEWIDGET_H
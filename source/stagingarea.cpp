@@ -4,25 +4,81 @@
 
 #include "stagingarea.h"
 #include "stepwidget.h"
+#include "stepresources.h"
 
 #include <QResizeEvent>
 #include <QPainter>
+#include <QMenu>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <algorithm>
+
+static const int Spacing = 10;
+static const int LoopSpacing = 10;
+static const int LoopIndent = 20;
+static const int Overscan = StepWidget::RowHeight; // Rows just outside the view get widgets too, so scrolling a little doesn't rebind
+
+//! Whether step is ancestor or one of its descendants.
+static bool IsWithin(Step *step, Step *ancestor)
+{
+    for (; step; step = step->parent())
+    {
+        if (step == ancestor)
+            return true;
+    }
+    return false;
+}
 
 StagingArea::StagingArea(TurboSetModel *model, IFontAwesome *fontAwesome, QWidget *parent)
     : QWidget(parent)
     , m_model(model)
     , m_fontAwesome(fontAwesome)
+    , m_idealWidth(0)
+    , m_idealHeight(0)
+    , m_relayoutPending(false)
+    , m_selectionAnchor(nullptr)
 {
     Q_ASSERT(model && fontAwesome);
+
+    QObject::connect(m_model, SIGNAL(stepInserted(Step*,int)), this, SLOT(onStepInserted(Step*,int)));
+    QObject::connect(m_model, SIGNAL(stepAboutToBeRemoved(Step*,int)), this, SLOT(onStepAboutToBeRemoved(Step*,int)));
+    QObject::connect(m_model, SIGNAL(stepRemoved(Step*,int)), this, SLOT(onStepRemoved(Step*,int)));
+    QObject::connect(m_model, SIGNAL(stepMoved(Step*,int,int)), this, SLOT(onStepMoved(Step*,int,int)));
+    QObject::connect(m_model, SIGNAL(stepUpdated(Step*)), this, SLOT(onStepUpdated(Step*)));
+    QObject::connect(m_model, SIGNAL(transactionCommitted()), this, SLOT(onTransactionCommitted()));
 }
 
 void StagingArea::clearView()
 {
-    for (auto step :  m_steps)
+    for (auto widget : m_visible)
     {
-        step->deleteLater();
+        releaseWidget(widget, false);
     }
-    m_steps.clear();
+    m_visible.clear();
+}
+
+void StagingArea::commitEdits()
+{
+    for (auto widget : m_visible)
+    {
+        widget->commitEdits();
+    }
+}
+
+std::vector<Step*> StagingArea::selection() const
+{
+    std::vector<Step*> steps(m_selection.begin(), m_selection.end());
+    std::sort(steps.begin(), steps.end(), [this](Step *a, Step *b)
+    {
+        return m_rowIndex.value(a) < m_rowIndex.value(b);
+    });
+    return steps;
+}
+
+void StagingArea::clearSelection()
+{
+    setSelection(QSet<Step*>());
+    m_selectionAnchor = nullptr;
 }
 
 int StagingArea::idealHeight() const
@@ -30,19 +86,241 @@ int StagingArea::idealHeight() const
     return m_idealHeight;
 }
 
+QRect StagingArea::stepRect(Step *step) const
+{
+    while (step && !m_rowIndex.contains(step))
+    {
+        step = step->parent();
+    }
+
+    if (!step)
+        return QRect();
+
+    return rowRect(m_rows[m_rowIndex.value(step)]);
+}
+
 void StagingArea::onSetChanged()
 {
+    // Steps may have been deleted, so no widget can keep its step.
     clearView();
+    m_relayoutPending = false;
+    m_selection.clear();
+    m_selectionAnchor = nullptr;
 
-    auto intervals = m_model->getIntervals();
-    for (auto step : intervals)
+    buildRows();
+    updateVisibleRows();
+    update();
+
+    emit sizeChanged();
+}
+
+void StagingArea::relayout(Step *container /*= nullptr*/)
+{
+    // Bulk edits only lay out once, when they're done.
+    if (m_model->inTransaction())
     {
-        addStep(step, this);
+        m_relayoutPending = true;
+        return;
     }
 
-    adjustLayout();
+    int oldHeight = m_idealHeight;
 
-    emit sizeChanged();
+    // A change inside a loop only moves that loop's rows, the rows below it and its ancestors' bottoms.
+    auto it = m_rowIndex.constFind(container);
+    if (m_relayoutPending || !container || it == m_rowIndex.constEnd())
+    {
+        m_relayoutPending = false;
+        buildRows();
+    }
+    else
+    {
+        relayoutBlock(it.value());
+    }
+
+    // Steps in loops which have been collapsed can't be seen, so they can't stay selected.
+    pruneSelection();
+
+    updateVisibleRows();
+    update();
+
+    if (m_idealHeight != oldHeight)
+        emit sizeChanged();
+}
+
+void StagingArea::onStepInserted(Step *parent, int index)
+{
+    Q_UNUSED(index);
+    relayout(parent);
+}
+
+void StagingArea::onStepAboutToBeRemoved(Step *parent, int index)
+{
+    Step *step = m_model->childAt(parent, index);
+
+    // The step and anything inside it leave the selection.
+    for (auto it = m_selection.begin(); it != m_selection.end(); )
+    {
+        if (IsWithin(*it, step))
+            it = m_selection.erase(it);
+        else
+            ++it;
+    }
+
+    if (IsWithin(m_selectionAnchor, step))
+        m_selectionAnchor = nullptr;
+
+    auto it = m_rowIndex.find(step);
+    if (it == m_rowIndex.end())
+        return; // In a collapsed loop, so never had a row
+
+    // The step and, for a loop, all of its children are going.
+    int first = it.value();
+    int bottom = m_rows[first].bottom;
+    for (size_t i = first; i < m_rows.size() && m_rows[i].y < bottom; ++i)
+    {
+        StepWidget *widget = m_visible.take(m_rows[i].step);
+        if (widget)
+            releaseWidget(widget, false);
+    }
+}
+
+void StagingArea::onStepRemoved(Step *parent, int index)
+{
+    Q_UNUSED(index);
+    relayout(parent);
+}
+
+void StagingArea::onStepMoved(Step *parent, int from, int to)
+{
+    Q_UNUSED(from);
+    Q_UNUSED(to);
+    relayout(parent);
+}
+
+void StagingArea::onStepUpdated(Step *step)
+{
+    StepWidget *widget = m_visible.value(step);
+    if (widget)
+        widget->setStep(step);
+
+    // An interval's row is always the same height, but a loop may have been expanded.
+    if (step->type() == StepType::Loop)
+        relayout(step);
+}
+
+void StagingArea::onExpandToggled(Step *step)
+{
+    relayout(step);
+}
+
+void StagingArea::onTransactionCommitted()
+{
+    if (m_relayoutPending)
+        relayout();
+}
+
+void StagingArea::onStepClicked(Step *step, Qt::KeyboardModifiers modifiers)
+{
+    QSet<Step*> selection;
+
+    if ((modifiers & Qt::ShiftModifier) && m_selectionAnchor && m_rowIndex.contains(m_selectionAnchor) && m_rowIndex.contains(step))
+    {
+        // Everything shown between the anchor and this step, added to the selection with ctrl.
+        if (modifiers & Qt::ControlModifier)
+            selection = m_selection;
+
+        int from = m_rowIndex.value(m_selectionAnchor);
+        int to = m_rowIndex.value(step);
+        for (int i = std::min(from, to); i <= std::max(from, to); ++i)
+        {
+            selection.insert(m_rows[i].step);
+        }
+    }
+    else if (modifiers & Qt::ControlModifier)
+    {
+        selection = m_selection;
+        if (!selection.remove(step))
+            selection.insert(step);
+
+        m_selectionAnchor = step;
+    }
+    else
+    {
+        // A plain click is for editing the step, and leaves nothing selected.
+        m_selectionAnchor = step;
+    }
+
+    setSelection(selection);
+}
+
+void StagingArea::onSelectionMenuRequested(const QPoint &globalPos)
+{
+    std::vector<Step*> steps = selection();
+    if (steps.empty())
+        return;
+
+    bool anyLoops = std::any_of(steps.begin(), steps.end(), [](Step *step)
+    {
+        return step->type() == StepType::Loop;
+    });
+
+    QMenu menu(this);
+    QMenu *changeType = menu.addMenu(m_fontAwesome->faIcon(fa::cogs), "Change type");
+    auto typeMap = AddTypesToMenu(changeType, m_fontAwesome);
+    QAction *scale = menu.addAction(m_fontAwesome->faIcon(fa::clocko), "Scale durations...");
+    menu.addSeparator();
+    QAction *wrap = menu.addAction(m_fontAwesome->faIcon(fa::objectgroup), "Wrap in loop");
+    wrap->setEnabled(TurboSetModel::areSiblings(steps));
+    QAction *unwrap = menu.addAction(m_fontAwesome->faIcon(fa::objectungroup), "Unwrap loop");
+    unwrap->setEnabled(anyLoops);
+    menu.addSeparator();
+    QAction *del = menu.addAction(m_fontAwesome->faIcon(fa::remove), QString("Delete %1 selected").arg(steps.size()));
+    QAction *clear = menu.addAction("Clear selection");
+
+    QAction *act = menu.exec(globalPos);
+    if (!act)
+        return;
+
+    // The edits are made to the steps, so anything the widgets are holding back goes in first.
+    commitEdits();
+
+    auto it = typeMap.find(act);
+    if (it != typeMap.end())
+    {
+        m_model->changeTypes(steps, it->second);
+    }
+    else if (act == scale)
+    {
+        bool ok = false;
+        int percent = QInputDialog::getInt(this, "Scale Durations", "New durations, as a percentage of the current ones:", 100, 1, 1000, 5, &ok);
+        if (ok && percent != 100)
+            m_model->scaleDurations(steps, percent / 100.0);
+    }
+    else if (act == wrap)
+    {
+        LoopStep *loop = m_model->wrapInLoop(steps);
+        setSelection(loop ? QSet<Step*>({ loop }) : QSet<Step*>());
+        m_selectionAnchor = loop;
+    }
+    else if (act == unwrap)
+    {
+        m_model->unwrapLoops(steps);
+    }
+    else if (act == del)
+    {
+        QMessageBox confirm;
+        confirm.setText(QString("Are you sure you want to delete these %1 items from the set?").arg(steps.size()));
+        confirm.setInformativeText("This action cannot be undone.");
+        confirm.setIcon(QMessageBox::Question);
+        confirm.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+        confirm.setDefaultButton(QMessageBox::No);
+        if (confirm.exec() == QMessageBox::Yes)
+            m_model->deleteSteps(steps);
+    }
+    else if (act == clear)
+    {
+        clearSelection();
+    }
 }
 
 bool StagingArea::event(QEvent *event)
@@ -52,79 +330,301 @@ bool StagingArea::event(QEvent *event)
         event->accept();
         return true;
     }
+
+    // The scroll area's viewport decides how much of the staging area is on screen.
+    if (event->type() == QEvent::ParentAboutToChange && parentWidget())
+        parentWidget()->removeEventFilter(this);
+    else if (event->type() == QEvent::ParentChange && parentWidget())
+        parentWidget()->installEventFilter(this);
+
     return QWidget::event(event);
 }
 
+bool StagingArea::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == parentWidget() && event->type() == QEvent::Resize)
+        updateVisibleRows();
+
+    return QWidget::eventFilter(watched, event);
+}
+
 void StagingArea::resizeEvent(QResizeEvent *event)
 {
     m_idealWidth = event->size().width();
     adjustLayout();
 }
 
-void StagingArea::paintEvent(QPaintEvent *event)
+void StagingArea::moveEvent(QMoveEvent *event)
 {
+    // The scroll area scrolls by moving this widget within its viewport.
     Q_UNUSED(event);
+    updateVisibleRows();
+}
+
+void StagingArea::paintEvent(QPaintEvent *event)
+{
     QPainter painter(this);
-    painter.fillRect(QRectF(QPointF(0.0f, 0.0f), size()), QColor(0x80, 0x80, 0x80));
+    QRect area = event->rect();
+    painter.fillRect(area, QColor(0x80, 0x80, 0x80));
+
+    if (m_rows.empty())
+        return;
+
+    auto paintLoop = [&](const Row &row)
+    {
+        QRect loop = loopRect(row);
+        if (!loop.intersects(area))
+            return;
+
+        painter.fillRect(loop, TypeToBgColour(StepType::Loop));
+        painter.fillRect(QRect(loop.left() + 5, row.y + StepWidget::RowHeight, 3, row.bottom - row.y - StepWidget::RowHeight), QColor(0x40, 0x40, 0x40));
+    };
+
+    // Loops that start above the area but reach into it are ancestors of the first row.
+    int start = std::max(firstRowBelow(area.top()) - 1, 0);
+    std::vector<int> ancestors;
+    for (int i = start; i >= 0; i = m_rows[i].parentRow)
+    {
+        ancestors.push_back(i);
+    }
+
+    for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it)
+    {
+        if (m_rows[*it].step->type() == StepType::Loop)
+            paintLoop(m_rows[*it]);
+    }
+
+    for (size_t i = start + 1; i < m_rows.size() && m_rows[i].y < area.bottom(); ++i)
+    {
+        if (m_rows[i].step->type() == StepType::Loop)
+            paintLoop(m_rows[i]);
+    }
 }
 
 void StagingArea::adjustLayout()
 {
-    static const int Spacing = 10;
-    int y = Spacing;
-    int width = m_idealWidth - (Spacing * 2);
+    updateVisibleRows();
+    update();
+}
 
-    for (auto step : m_steps)
+void StagingArea::buildRows()
+{
+    m_rows.clear();
+
+    int y = Spacing;
+    auto intervals = m_model->getIntervals();
+    for (auto step : intervals)
     {
-        step->setVisible(true);
-        step->setGeometry(Spacing, y, width, step->idealHeight());
-        y += step->idealHeight() + Spacing;
+        y = addRows(m_rows, 0, step, -1, 0, y) + Spacing;
     }
 
     m_idealHeight = y;
+    indexRows(0);
 }
 
-void StagingArea::addStep(Step *step, QWidget *parent)
+void StagingArea::relayoutBlock(const int first)
 {
-    StepWidget *newStep = nullptr;
-    if (step->type() == StepType::Loop)
+    // The block's old extent, before its rows are replaced.
+    const Row old = m_rows[first];
+    size_t end = first + 1;
+    while (end < m_rows.size() && m_rows[end].y < old.bottom)
     {
-        newStep = new LoopStepWidget(step, m_fontAwesome, parent);
-        size_t children = step->getChildCount();
+        m_rowIndex.remove(m_rows[end].step);
+        ++end;
+    }
+
+    std::vector<Row> block;
+    int bottom = addRows(block, first, old.step, old.parentRow, old.depth, old.y);
+    int shift = bottom - old.bottom;
+    int added = (int)block.size() - (int)(end - first);
+
+    m_rows.erase(m_rows.begin() + first, m_rows.begin() + end);
+    m_rows.insert(m_rows.begin() + first, block.begin(), block.end());
+
+    // Everything after the block slides by the change in its height...
+    for (size_t i = first + block.size(); i < m_rows.size(); ++i)
+    {
+        Row &row = m_rows[i];
+        row.y += shift;
+        row.bottom += shift;
+        if (row.parentRow > first)
+            row.parentRow += added;
+    }
+
+    // ...and each enclosing loop grows or shrinks by the same amount.
+    for (int i = old.parentRow; i >= 0; i = m_rows[i].parentRow)
+    {
+        m_rows[i].bottom += shift;
+    }
+
+    m_idealHeight += shift;
+    indexRows(first);
+}
+
+void StagingArea::indexRows(const int first)
+{
+    if (first == 0)
+        m_rowIndex.clear();
+
+    for (size_t i = first; i < m_rows.size(); ++i)
+    {
+        m_rowIndex.insert(m_rows[i].step, (int)i);
+    }
+}
+
+int StagingArea::addRows(std::vector<Row> &rows, const int base, Step *step, int parentRow, int depth, int y)
+{
+    int local = (int)rows.size();
+    int index = base + local;
+    Row row = { step, parentRow, depth, y, y + StepWidget::RowHeight };
+    rows.push_back(row);
+
+    // Collapsed loops are left alone, so a lazily-loaded loop isn't parsed until it's opened
+    LoopStep *loop = dynamic_cast<LoopStep*>(step);
+    if (loop && loop->expanded())
+    {
+        int childY = row.bottom;
+        size_t children = loop->getChildCount();
         for (size_t i = 0; i < children; i++)
         {
-            Step *child = step->getChild(i);
-            addStep(child, newStep);
+            childY = addRows(rows, base, loop->getChild(i), index, depth + 1, childY) + LoopSpacing;
         }
+        rows[local].bottom = childY;
     }
-    else
+
+    return rows[local].bottom;
+}
+
+void StagingArea::updateVisibleRows()
+{
+    QRect area = visibleArea().adjusted(0, -Overscan, 0, Overscan);
+
+    QHash<Step*, StepWidget*> visible;
+    for (size_t i = firstRowBelow(area.top()); i < m_rows.size() && m_rows[i].y < area.bottom(); ++i)
     {
-        newStep = new IntervalWidget(step, m_fontAwesome, parent);
+        Step *step = m_rows[i].step;
+        StepWidget *widget = m_visible.take(step);
+        if (!widget)
+            widget = acquireWidget(step);
+
+        widget->setSelected(m_selection.contains(step));
+
+        widget->setGeometry(rowRect(m_rows[i]));
+        widget->show();
+        visible.insert(step, widget);
     }
 
-    if (!newStep)
+    // Whatever's left has scrolled out of view.
+    for (auto widget : m_visible)
     {
-        Q_ASSERT(false);
-        return;
+        releaseWidget(widget, true);
     }
+    m_visible = visible;
+}
+
+QRect StagingArea::visibleArea() const
+{
+    if (!parentWidget())
+        return rect();
+
+    return QRect(-pos(), parentWidget()->size()).intersected(rect());
+}
+
+QRect StagingArea::rowRect(const Row &row) const
+{
+    int indent = row.depth * LoopIndent;
+    return QRect(Spacing + indent, row.y, m_idealWidth - (Spacing * 2) - indent, StepWidget::RowHeight);
+}
+
+QRect StagingArea::loopRect(const Row &row) const
+{
+    QRect rect = rowRect(row);
+    rect.setBottom(row.bottom - 1);
+    return rect;
+}
+
+int StagingArea::firstRowBelow(const int y) const
+{
+    auto it = std::partition_point(m_rows.begin(), m_rows.end(), [y](const Row &row)
+    {
+        return row.y + StepWidget::RowHeight <= y;
+    });
+    return (int)(it - m_rows.begin());
+}
 
-    LoopStepWidget *loopParent = dynamic_cast<LoopStepWidget*>(parent);
-    if (loopParent)
+StepWidget* StagingArea::acquireWidget(Step *step)
+{
+    StepWidget *widget = nullptr;
+    if (step->type() == StepType::Loop)
     {
-        loopParent->addChild(newStep);
-        QObject::connect(newStep, SIGNAL(deleted(Step*)), loopParent, SLOT(onStepDeleted(Step*)), Qt::DirectConnection);
-        QObject::connect(newStep, SIGNAL(movedUp(Step*)), loopParent, SLOT(onStepMovedUp(Step*)), Qt::DirectConnection);
-        QObject::connect(newStep, SIGNAL(movedDown(Step*)), loopParent, SLOT(onStepMovedDown(Step*)), Qt::DirectConnection);
-        QObject::connect(newStep, SIGNAL(typeChanged(Step*,StepType)), loopParent, SLOT(onTypeChanged(Step*,StepType)), Qt::DirectConnection);
+        if (!m_spareLoops.isEmpty())
+        {
+            widget = m_spareLoops.takeLast();
+            widget->setStep(step);
+            return widget;
+        }
 
+        widget = new LoopStepWidget(step, m_fontAwesome, this);
+        QObject::connect(widget, SIGNAL(expandToggled(Step*)), this, SLOT(onExpandToggled(Step*)), Qt::DirectConnection);
     }
     else
     {
-        m_steps.push_back(newStep);
-        QObject::connect(newStep, SIGNAL(deleted(Step*)), m_model, SLOT(onStepDeleted(Step*)), Qt::DirectConnection);
-        QObject::connect(newStep, SIGNAL(movedUp(Step*)), m_model, SLOT(onStepMovedUp(Step*)), Qt::DirectConnection);
-        QObject::connect(newStep, SIGNAL(movedDown(Step*)), m_model, SLOT(onStepMovedDown(Step*)), Qt::DirectConnection);
-        QObject::connect(newStep, SIGNAL(typeChanged(Step*,StepType)), m_model, SLOT(onTypeChanged(Step*,StepType)), Qt::DirectConnection);
+        if (!m_spareIntervals.isEmpty())
+        {
+            widget = m_spareIntervals.takeLast();
+            widget->setStep(step);
+            return widget;
+        }
+
+        widget = new IntervalWidget(step, m_fontAwesome, this);
+    }
+
+    // The model handles steps at any depth, so it doesn't matter which step the widget is showing.
+    QObject::connect(widget, SIGNAL(deleted(Step*)), m_model, SLOT(onStepDeleted(Step*)), Qt::DirectConnection);
+    QObject::connect(widget, SIGNAL(movedUp(Step*)), m_model, SLOT(onStepMovedUp(Step*)), Qt::DirectConnection);
+    QObject::connect(widget, SIGNAL(movedDown(Step*)), m_model, SLOT(onStepMovedDown(Step*)), Qt::DirectConnection);
+    QObject::connect(widget, SIGNAL(typeChanged(Step*,StepType)), m_model, SLOT(onTypeChanged(Step*,StepType)), Qt::DirectConnection);
+    QObject::connect(widget, SIGNAL(clicked(Step*,Qt::KeyboardModifiers)), this, SLOT(onStepClicked(Step*,Qt::KeyboardModifiers)), Qt::DirectConnection);
+    QObject::connect(widget, SIGNAL(selectionMenuRequested(QPoint)), this, SLOT(onSelectionMenuRequested(QPoint)));
+
+    return widget;
+}
+
+void StagingArea::releaseWidget(StepWidget *widget, const bool keepEdits)
+{
+    if (keepEdits)
+        widget->commitEdits();
+    else
+        widget->discardEdits();
+
+    widget->hide();
+
+    if (LoopStepWidget *loop = dynamic_cast<LoopStepWidget*>(widget))
+        m_spareLoops.push_back(loop);
+    else if (IntervalWidget *interval = dynamic_cast<IntervalWidget*>(widget))
+        m_spareIntervals.push_back(interval);
+}
+
+void StagingArea::setSelection(const QSet<Step*> &selection)
+{
+    m_selection = selection;
+
+    for (auto it = m_visible.constBegin(); it != m_visible.constEnd(); ++it)
+    {
+        it.value()->setSelected(m_selection.contains(it.key()));
+    }
+}
+
+void StagingArea::pruneSelection()
+{
+    for (auto it = m_selection.begin(); it != m_selection.end(); )
+    {
+        if (m_rowIndex.contains(*it))
+            ++it;
+        else
+            it = m_selection.erase(it);
     }
 
+    if (m_selectionAnchor && !m_rowIndex.contains(m_selectionAnchor))
+        m_selectionAnchor = nullptr;
 }
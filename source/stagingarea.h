@@ -6,14 +6,32 @@
 #define STAGINGAREA_H
 
 #include <QWidget>
-#include <QVBoxLayout>
 #include <QList>
+#include <QHash>
+#include <QSet>
+#include <vector>
 
 #include "turbosetmodel.h"
 #include "stepwidget.h"
 #include "ifontawesome.h"
 
-/*! Widget used to set up the turbo set */
+/*!
+ * Widget used to set up the turbo set.
+ *
+ * The set is flattened into rows, one per step, with the children of expanded loops
+ * indented beneath their loop. Widgets are only created for the rows that intersect
+ * the visible part of the enclosing scroll area, and are recycled as it scrolls, so
+ * the cost of the view doesn't grow with the size of the set. Loop backgrounds are
+ * painted by the staging area itself, as the loop's rows may not all have widgets.
+ *
+ * Edits to individual steps only recompute the row positions; widgets stay bound to
+ * their steps, so only the widgets for the steps involved are created or rebound.
+ * Each loop's extent is cached in its row, so an edit inside a loop only rebuilds
+ * that loop's rows, shifts the rows below and adjusts the loops enclosing it.
+ *
+ * Steps can be selected with ctrl- and shift-clicks. The context menu of a selected
+ * step then edits the whole selection, in a single model transaction.
+ */
 class StagingArea : public QWidget
 {
     Q_OBJECT
@@ -22,28 +40,86 @@ public:
 
     int idealHeight() const;
 
+    //! Where a step's row is, or that of its closest enclosing loop if it's inside a collapsed loop.
+    QRect stepRect(Step *step) const;
+
+    //! Apply edits the widgets are still holding back, e.g. before saving.
+    void commitEdits();
+
+    //! The selected steps, in the order they're shown.
+    std::vector<Step*> selection() const;
+    void clearSelection();
+
 signals:
     void sizeChanged();
 
 public slots:
     void onSetChanged();
 
+protected slots:
+    void onStepInserted(Step *parent, int index);
+    void onStepAboutToBeRemoved(Step *parent, int index);
+    void onStepRemoved(Step *parent, int index);
+    void onStepMoved(Step *parent, int from, int to);
+    void onStepUpdated(Step *step);
+
+    void onExpandToggled(Step *step);
+    void onTransactionCommitted();
+
+    void onStepClicked(Step *step, Qt::KeyboardModifiers modifiers);
+    void onSelectionMenuRequested(const QPoint &globalPos);
+
 protected: // Event handlers
     bool event(QEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
+    void moveEvent(QMoveEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
 
 protected:
+    /*! A step's place in the flattened set */
+    struct Row
+    {
+        Step *step;
+        int parentRow;      //!< Index of the parent's row, -1 at the top level.
+        int depth;
+        int y;
+        int bottom;         //!< Bottom of the step including, for loops, all of its rows.
+    };
+
     void clearView();
+    void relayout(Step *container = nullptr);
+    void buildRows();
+    void relayoutBlock(const int first);
+    void indexRows(const int first);
+    int addRows(std::vector<Row> &rows, const int base, Step *step, int parentRow, int depth, int y);
     void adjustLayout();
-    void addStep(Step *step, QWidget *parent);
+    void updateVisibleRows();
+
+    QRect visibleArea() const;
+    QRect rowRect(const Row &row) const;
+    QRect loopRect(const Row &row) const;
+    int firstRowBelow(const int y) const;
+
+    StepWidget* acquireWidget(Step *step);
+    void releaseWidget(StepWidget *widget, const bool keepEdits);
+
+    void setSelection(const QSet<Step*> &selection);
+    void pruneSelection();
 
 protected:
     TurboSetModel *m_model;
-    QList<StepWidget*> m_steps;
     IFontAwesome *m_fontAwesome;
+    std::vector<Row> m_rows;
+    QHash<Step*, int> m_rowIndex;
+    QHash<Step*, StepWidget*> m_visible;
+    QList<IntervalWidget*> m_spareIntervals;
+    QList<LoopStepWidget*> m_spareLoops;
     int m_idealWidth;
     int m_idealHeight;
+    bool m_relayoutPending;     //!< Set while the model is in a transaction.
+    QSet<Step*> m_selection;
+    Step *m_selectionAnchor;    //!< Where a shift-click's range starts.
 };
 
 #endif // STAGINGAREA_H
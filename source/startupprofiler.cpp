@@ -0,0 +1,100 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "startupprofiler.h"
+#include <QWidget>
+#include <QEvent>
+#include <QTimer>
+#include <QDebug>
+
+StartupProfiler::StartupProfiler(QObject *parent)
+    : QObject(parent)
+    , m_lastMark(0)
+    , m_enabled(false)
+    , m_started(false)
+{
+}
+
+StartupProfiler& StartupProfiler::instance()
+{
+    static StartupProfiler profiler;
+    return profiler;
+}
+
+void StartupProfiler::start()
+{
+    m_timer.start();
+    m_lastMark = 0;
+    m_phases.clear();
+    m_started = false;
+}
+
+void StartupProfiler::setEnabled(const bool enabled)
+{
+    m_enabled = enabled;
+}
+
+bool StartupProfiler::isEnabled() const
+{
+    return m_enabled;
+}
+
+void StartupProfiler::mark(const QString &phase)
+{
+    if (!m_timer.isValid() || m_started)
+        return;
+
+    qint64 now = m_timer.elapsed();
+    m_phases.append(qMakePair(phase, now - m_lastMark));
+    m_lastMark = now;
+}
+
+void StartupProfiler::deferred(const QString &phase, const qint64 msecs)
+{
+    if (m_enabled)
+        qInfo().noquote() << QString("%1: %2 ms (deferred, %3 ms after start)").arg(phase).arg(msecs).arg(m_timer.elapsed());
+}
+
+void StartupProfiler::watchFirstPaint(QWidget *widget)
+{
+    if (!widget)
+    {
+        Q_ASSERT(false);
+        return;
+    }
+
+    m_watched = widget;
+    widget->installEventFilter(this);
+}
+
+bool StartupProfiler::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_watched && event->type() == QEvent::Paint)
+    {
+        m_watched->removeEventFilter(this);
+        m_watched.clear();
+
+        // Report once the paint has been done, rather than as it begins.
+        QTimer::singleShot(0, this, [this]()
+        {
+            mark("First paint");
+            m_started = true;
+            report();
+        });
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void StartupProfiler::report()
+{
+    if (!m_enabled)
+        return;
+
+    for (const auto &phase : m_phases)
+    {
+        qInfo().noquote() << QString("%1: %2 ms").arg(phase.first, -24).arg(phase.second, 5);
+    }
+    qInfo().noquote() << QString("%1: %2 ms").arg("Time to first paint", -24).arg(m_lastMark, 5);
+}
@@ -0,0 +1,61 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+#include <QPair>
+
+class QWidget;
+
+/*!
+ * Times the phases of starting the application, up to the main window's first paint.
+ *
+ * Phases are marked as they complete, each recording the time since the previous mark.
+ * They're always recorded (it's just a clock read), but only logged when enabled, e.g.
+ * with --profile-startup on the command line. Work deferred until first use is timed
+ * by the caller and logged as it happens.
+ */
+class StartupProfiler : public QObject
+{
+    Q_OBJECT
+public:
+    static StartupProfiler& instance();
+
+    //! Start the clock, as early in main() as possible.
+    void start();
+
+    void setEnabled(const bool enabled);
+    bool isEnabled() const;
+
+    //! Record that a phase has just finished.
+    void mark(const QString &phase);
+
+    //! Log the time taken by work that was deferred until it was first needed.
+    void deferred(const QString &phase, const qint64 msecs);
+
+    //! Finish (and log) the startup phases when the widget is first painted.
+    void watchFirstPaint(QWidget *widget);
+
+protected:
+    explicit StartupProfiler(QObject *parent = nullptr);
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void report();
+
+protected:
+    QElapsedTimer m_timer;
+    qint64 m_lastMark;
+    QVector<QPair<QString, qint64> > m_phases;
+    QPointer<QWidget> m_watched;
+    bool m_enabled;
+    bool m_started;             //!< Set once the first paint has been reached.
+};
+
+#endif // STARTUPPROFILER_H
@@ -4,6 +4,9 @@
 
 #include "step.h"
 #include "turbosetmodel.h"
+#include "lazysetloader.h"
+#include <QXmlStreamReader>
+#include <algorithm>
 
 void Interval::serialise(QDomDocument &file, QDomElement &parent) const
 {
@@ -57,6 +60,26 @@ Interval *Interval::fromXml(QDomElement &node, IStepManager *manager)
     return interval;
 }
 
+Interval *Interval::fromXml(QXmlStreamReader &reader, IStepManager *manager)
+{
+    QXmlStreamAttributes attributes = reader.attributes();
+    reader.skipCurrentElement();
+
+    if (!attributes.hasAttribute(TurboSetModel::TypeAttr)
+            || !attributes.hasAttribute(TurboSetModel::DurationAttr)
+            || !attributes.hasAttribute(TurboSetModel::TextAttr))
+    {
+        return nullptr;
+    }
+
+    StepType type = (StepType)attributes.value(TurboSetModel::TypeAttr).toUInt();
+    Interval *interval = new Interval(type, manager);
+    interval->m_duration = attributes.value(TurboSetModel::DurationAttr).toUInt();
+    interval->m_text = attributes.value(TurboSetModel::TextAttr).toString();
+
+    return interval;
+}
+
 bool Interval::populateFromXml(QDomElement &node)
 {
     if (node.attributeNode(TurboSetModel::DurationAttr).isNull()
@@ -76,6 +99,12 @@ LoopStep::LoopStep(IStepManager *manager)
     , m_iterations(0)
     , m_playbackIteration(0)
     , m_playbackStep(nullptr)
+    , m_expanded(true)
+    , m_lazyBegin(0)
+    , m_lazyEnd(0)
+    , m_lazyChildCount(0)
+    , m_lazyDuration(0)
+    , m_lazyPlayedDuration(0)
 {
 
 }
@@ -91,6 +120,9 @@ LoopStep::~LoopStep()
 
 unsigned int LoopStep::duration() const
 {
+    if (m_lazySource)
+        return m_lazyDuration;
+
     unsigned int duration = 0;
     for (auto child : m_children)
     {
@@ -99,14 +131,44 @@ unsigned int LoopStep::duration() const
     return duration;
 }
 
+unsigned int LoopStep::playedIterations(const unsigned int iterations)
+{
+    // A loop with zero iterations still plays through once, see nextInterval().
+    return std::max(iterations, 1u);
+}
+
+quint64 LoopStep::playedDuration() const
+{
+    if (m_lazySource)
+        return m_lazyPlayedDuration * playedIterations();
+
+    quint64 duration = 0;
+    for (auto child : m_children)
+    {
+        const LoopStep *loop = dynamic_cast<const LoopStep*>(child);
+        duration += loop ? loop->playedDuration() : child->duration();
+    }
+    return duration * playedIterations();
+}
+
 void LoopStep::addChild(Step *child)
 {
+    // The caller notifies the manager, this is also used while loading.
+    materialise();
+    child->setParent(this);
     m_children.push_back(child);
-    notifyChange();
+}
+
+size_t LoopStep::indexOf(const Step *child) const
+{
+    auto it = std::find(m_children.begin(), m_children.end(), child);
+    return it != m_children.end() ? (size_t)(it - m_children.begin()) : SIZE_MAX;
 }
 
 Step *LoopStep::getChild(size_t index) const
 {
+    materialise();
+
     if (index >= m_children.size())
     {
         Q_ASSERT(false);
@@ -117,6 +179,22 @@ Step *LoopStep::getChild(size_t index) const
 
 void LoopStep::serialise(QDomDocument &file, QDomElement &parent) const
 {
+    if (m_lazySource)
+    {
+        // Copy the untouched loop straight from the source rather than creating its children.
+        QDomDocument fragment;
+        if (fragment.setContent(m_lazySource->slice(m_lazyBegin, m_lazyEnd)))
+        {
+            QDomElement el = file.importNode(fragment.documentElement(), true).toElement();
+            el.setAttribute(TurboSetModel::IterationsAttr, m_iterations);
+            parent.appendChild(el);
+            return;
+        }
+
+        Q_ASSERT(false);
+        materialise();
+    }
+
     QDomElement el = file.createElement(TurboSetModel::LoopTag);
     el.setAttribute(TurboSetModel::IterationsAttr, m_iterations);
 
@@ -130,6 +208,8 @@ void LoopStep::serialise(QDomDocument &file, QDomElement &parent) const
 
 Interval *LoopStep::nextInterval()
 {
+    materialise();
+
     if (m_children.empty())
         return nullptr;
 
@@ -170,6 +250,8 @@ Interval *LoopStep::nextInterval()
 
 Interval *LoopStep::queryNext(bool reset /*= false*/)
 {
+    materialise();
+
     if (m_children.empty())
         return nullptr;
 
@@ -214,6 +296,8 @@ void LoopStep::resetPlayback()
 
 Interval *LoopStep::currentInterval()
 {
+    materialise();
+
     if (m_children.empty())
         return nullptr;
 
@@ -221,6 +305,49 @@ Interval *LoopStep::currentInterval()
     return step->currentInterval();
 }
 
+void LoopStep::setLazyBody(const QSharedPointer<const LazySetSource> &source, const qint64 begin, const qint64 end,
+                           const unsigned int iterations, const size_t childCount, const unsigned int duration,
+                           const quint64 playedDuration)
+{
+    Q_ASSERT(m_children.empty());
+
+    m_lazySource = source;
+    m_lazyBegin = begin;
+    m_lazyEnd = end;
+    m_iterations = iterations;
+    m_lazyChildCount = childCount;
+    m_lazyDuration = duration;
+    m_lazyPlayedDuration = playedDuration;
+    m_expanded = false;
+}
+
+void LoopStep::materialise() const
+{
+    if (!m_lazySource)
+        return;
+
+    LoopStep *self = const_cast<LoopStep*>(this);
+    if (m_manager)
+        m_manager->notifyAboutToMaterialise(self, m_lazyChildCount);
+
+    // Release the source first, the children keep their own reference to it for any nested loops.
+    LazySetSourcePtr source = m_lazySource;
+    m_lazySource.reset();
+
+    if (!LazySetLoader::loadLoopBody(source, m_lazyBegin, m_lazyEnd, m_manager, m_children))
+    {
+        Q_ASSERT(false);
+    }
+
+    for (auto child : m_children)
+    {
+        child->setParent(self);
+    }
+
+    if (m_manager)
+        m_manager->notifyMaterialised(self);
+}
+
 bool LoopStep::deleteStep(Step *step)
 {
     auto it = m_children.begin();
@@ -229,11 +356,15 @@ bool LoopStep::deleteStep(Step *step)
         Step *child = *it;
         if (child == step)
         {
+            size_t index = it - m_children.begin();
+            if (m_manager)
+                m_manager->notifyAboutToRemove(this, index);
+
             delete step;
             m_children.erase(it);
 
             if (m_manager)
-                m_manager->notifyChange(true);
+                m_manager->notifyRemoved(this, index);
 
             return true;
         }
@@ -243,6 +374,49 @@ bool LoopStep::deleteStep(Step *step)
     return false;
 }
 
+Step* LoopStep::takeChild(size_t index)
+{
+    materialise();
+
+    if (index >= m_children.size())
+    {
+        Q_ASSERT(false);
+        return nullptr;
+    }
+
+    if (m_manager)
+        m_manager->notifyAboutToRemove(this, index);
+
+    Step *child = m_children.at(index);
+    m_children.erase(m_children.begin() + index);
+    child->setParent(nullptr);
+
+    if (m_manager)
+        m_manager->notifyRemoved(this, index);
+
+    return child;
+}
+
+void LoopStep::insertChild(size_t index, Step *child)
+{
+    materialise();
+
+    if (!child || index > m_children.size())
+    {
+        Q_ASSERT(false);
+        return;
+    }
+
+    if (m_manager)
+        m_manager->notifyAboutToInsert(this, index);
+
+    child->setParent(this);
+    m_children.insert(m_children.begin() + index, child);
+
+    if (m_manager)
+        m_manager->notifyInserted(this, index);
+}
+
 bool LoopStep::moveStepUp(Step *step)
 {
     if (m_children.empty())
@@ -264,12 +438,15 @@ bool LoopStep::moveStepUp(Step *step)
     if (cur >= max)
         return false; // Not a child of this Loop
 
+    if (m_manager)
+        m_manager->notifyAboutToMove(this, cur, prev);
+
     Step *temp = m_children.at(cur);
     m_children[cur] = m_children.at(prev);
     m_children[prev] = temp;
 
     if (m_manager)
-        m_manager->notifyChange(true);
+        m_manager->notifyMoved(this, cur, prev);
 
     return true;
 }
@@ -290,10 +467,14 @@ bool LoopStep::moveStepDown(Step *step)
     if (itNext == m_children.end())
         return true; // It's a child but the last element, nothing to do
 
+    size_t from = it - m_children.begin();
+    if (m_manager)
+        m_manager->notifyAboutToMove(this, from, from + 1);
+
     std::iter_swap(it, itNext);
 
     if (m_manager)
-        m_manager->notifyChange(true);
+        m_manager->notifyMoved(this, from, from + 1);
 
     return true;
 }
@@ -309,18 +490,41 @@ bool LoopStep::changeType(Step *step, const StepType newType)
     if (it == m_children.end())
         return false; // Not a child of this Loop
 
-    if (newType == StepType::Loop)
+    if ((newType == StepType::Loop) == ((*it)->type() == StepType::Loop))
     {
-        delete *it;
-        *it = new LoopStep(m_manager);
+        (*it)->setType(newType);
+
+        if (m_manager)
+            m_manager->notifyUpdated(*it);
+
+        return true;
     }
-    else
+
+    // Switching between an interval and a loop needs a different kind of step.
+    size_t index = it - m_children.begin();
+    if (m_manager)
+        m_manager->notifyAboutToRemove(this, index);
+
+    delete *it;
+    m_children.erase(it);
+
+    if (m_manager)
     {
-        (*it)->setType(newType);
+        m_manager->notifyRemoved(this, index);
+        m_manager->notifyAboutToInsert(this, index);
     }
 
+    Step *replacement = nullptr;
+    if (newType == StepType::Loop)
+        replacement = new LoopStep(m_manager);
+    else
+        replacement = new Interval(newType, m_manager);
+
+    replacement->setParent(this);
+    m_children.insert(m_children.begin() + index, replacement);
+
     if (m_manager)
-        m_manager->notifyChange(true);
+        m_manager->notifyInserted(this, index);
 
     return true;
 }
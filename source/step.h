@@ -8,10 +8,14 @@
 #include "types.h"
 #include "istepmanager.h"
 #include <QtXml/QDomElement>
+#include <QSharedPointer>
 #include <vector>
 #include <cstdint>
 
 class Interval;
+class LoopStep;
+class LazySetSource;
+class QXmlStreamReader;
 
 /*! Base class representing a step in the set */
 class Step
@@ -20,11 +24,16 @@ public:
     Step(const StepType type, IStepManager *manager)
         : m_type(type)
         , m_manager(manager)
+        , m_parent(nullptr)
         , m_duration(60)
     {
         Q_ASSERT(m_manager != nullptr);
     }
 
+    virtual ~Step()
+    {
+    }
+
     StepType type() const
     {
         return m_type;
@@ -57,15 +66,27 @@ public:
     virtual size_t getChildCount() const = 0;
     virtual Step* getChild(size_t index) const = 0;
 
+    //! The loop containing this step, nullptr at the top level of the set.
+    LoopStep* parent() const
+    {
+        return m_parent;
+    }
+
+    void setParent(LoopStep *parent)
+    {
+        m_parent = parent;
+    }
+
     void notifyChange()
     {
         if (m_manager)
-            m_manager->notifyChange();
+            m_manager->notifyDataChanged(this);
     }
 
 protected:
     StepType m_type;
     IStepManager *m_manager;
+    LoopStep *m_parent;
     unsigned int m_duration;
 };
 
@@ -127,6 +148,9 @@ public:
 
     static Interval* fromXml(QDomElement &node, IStepManager *manager);
 
+    //! Create an interval from the start element the reader is positioned on, consuming the element.
+    static Interval* fromXml(QXmlStreamReader &reader, IStepManager *manager);
+
 protected:
     bool populateFromXml(QDomElement &node);
 
@@ -137,7 +161,10 @@ protected:
 
 /*! Loop Step - represents a loop in the set,
  * will contain children Step objects,
- * each of which will be iterated over according to m_iterations */
+ * each of which will be iterated over according to m_iterations.
+ *
+ * A loop loaded lazily (see LazySetLoader) only knows its child count and duration,
+ * its children are parsed from the source the first time they are needed. */
 class LoopStep : public Step
 {
 public:
@@ -148,11 +175,14 @@ public:
 
     size_t getChildCount() const override
     {
-        return m_children.size();
+        return m_lazySource ? m_lazyChildCount : m_children.size();
     }
 
     void addChild(Step *child);
 
+    //! The position of a child within this loop, or SIZE_MAX if it isn't one.
+    size_t indexOf(const Step *child) const;
+
     Step* getChild(size_t index) const override;
 
     virtual void serialise(QDomDocument &file, QDomElement &parent) const override;
@@ -169,6 +199,18 @@ public:
         return m_iterations;
     }
 
+    //! How many times the loop's children are played, which is at least once.
+    unsigned int playedIterations() const
+    {
+        return playedIterations(m_iterations);
+    }
+
+    //! How many times the children of a loop with the given iteration count are played.
+    static unsigned int playedIterations(const unsigned int iterations);
+
+    //! Seconds the loop plays for, counting its iterations and those of any loops within it.
+    quint64 playedDuration() const;
+
     virtual bool currentIteration(uint32_t &current, uint32_t &total) override
     {
         current = m_playbackIteration + 1; // zero-based index, present as one-based
@@ -177,6 +219,13 @@ public:
     }
 
     bool deleteStep(Step *step);
+
+    //! Remove a child without deleting it, so it can be placed elsewhere. The caller owns the child.
+    Step* takeChild(size_t index);
+
+    //! Place a step, e.g. one taken from elsewhere, among this loop's children.
+    void insertChild(size_t index, Step *child);
+
     bool moveStepUp(Step *step);
     bool moveStepDown(Step *step);
     bool changeType(Step *step, const StepType newType);
@@ -187,11 +236,53 @@ public:
         notifyChange();
     }
 
+    /*!
+     * Defer loading of this loop's children.
+     * \param source The content of the set file the loop was read from.
+     * \param begin Byte offset of the loop's start tag within source.
+     * \param end Byte offset just past the loop's end tag within source.
+     * \param iterations The loop's iteration count.
+     * \param childCount The number of children the loop will have once loaded.
+     * \param duration The loop's duration once loaded.
+     * \param playedDuration Seconds one iteration plays for, counting the iterations of nested loops.
+     */
+    void setLazyBody(const QSharedPointer<const LazySetSource> &source, const qint64 begin, const qint64 end,
+                     const unsigned int iterations, const size_t childCount, const unsigned int duration,
+                     const quint64 playedDuration);
+
+    //! Query whether the children of this loop have been created yet.
+    bool isMaterialised() const
+    {
+        return !m_lazySource;
+    }
+
+    //! Parse the children of a lazily-loaded loop, if that hasn't happened already.
+    void materialise() const;
+
+    //! Whether the loop's children are shown in the editor. Purely presentational, not saved.
+    bool expanded() const
+    {
+        return m_expanded;
+    }
+
+    void setExpanded(const bool expanded)
+    {
+        m_expanded = expanded;
+    }
+
 protected:
-    std::vector<Step*> m_children;
+    mutable std::vector<Step*> m_children;
     unsigned int m_iterations;
     unsigned int m_playbackIteration;
     Step *m_playbackStep;
+    bool m_expanded;
+
+    mutable QSharedPointer<const LazySetSource> m_lazySource;
+    qint64 m_lazyBegin;
+    qint64 m_lazyEnd;
+    size_t m_lazyChildCount;
+    unsigned int m_lazyDuration;
+    quint64 m_lazyPlayedDuration;
 };
 
 #endif // STEP_H
@@ -3,6 +3,7 @@
  *************************************/
 
 #include "stepresources.h"
+#include "fontfitcache.h"
 #include "QtAwesome/QtAwesome.h"
 #include <QLabel>
 #include <QMenu>
@@ -78,16 +79,15 @@ void UpdateLabelFontSize(QLabel *label, bool maxHeight /*= true*/)
     if (!label)
         return;
 
-    QFontMetrics metrics(label->font());
+    qreal size = maxHeight
+            ? FontFitCache::fitHeight(label->font(), label->height())
+            : FontFitCache::fitWidth(label->font(), label->text(), label->width());
 
-    float factor = maxHeight
-            ? (float)label->height() / (float)metrics.height()
-            : (float)label->width() / (float)metrics.width(label->text());
-
-    if ((factor < 1) || (factor > 1.25))
+    // Setting the font invalidates the label's layout, so only do it when the size really changes.
+    if (qAbs(size - label->font().pointSizeF()) > 0.01)
     {
         QFont scaledFont(label->font());
-        scaledFont.setPointSizeF(scaledFont.pointSizeF() * factor);
+        scaledFont.setPointSizeF(size);
         label->setFont(scaledFont);
     }
 }
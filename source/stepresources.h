@@ -31,6 +31,7 @@ QColor TypeToBgColour(const StepType type);
 
 /*!
  * Scale the label's font's size according to the size of of the label.
+ * The size is looked up in (or computed once for) the FontFitCache.
  * \param label A pointer to the label in question.
  * \param maxHeight Denotes whether to use the label's height or its width to determine the scaling.
  */
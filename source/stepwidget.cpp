@@ -6,11 +6,14 @@
 #include <QPainter>
 #include <QMessageBox>
 #include <QMenu>
+#include <QSignalBlocker>
+#include <QMouseEvent>
 #include "step.h"
 #include "stepresources.h"
 
-static const int StepHeight = 110;
-static const int LoopSpacing = 10;
+static const int StepHeight = StepWidget::RowHeight;
+static const int TextCommitDelay = 400; // ms
+static const int SelectionWidth = 4;
 
 StepWidget::StepWidget(Step *step, IFontAwesome *fontAwesome, QWidget *parent)
     : QWidget(parent)
@@ -21,9 +24,35 @@ StepWidget::StepWidget(Step *step, IFontAwesome *fontAwesome, QWidget *parent)
     , m_titleArea(nullptr)
     , m_title(nullptr)
     , m_icon(nullptr)
+    , m_selected(false)
 {
 }
 
+void StepWidget::setStep(Step *step)
+{
+    if (!step)
+    {
+        Q_ASSERT(false);
+        return;
+    }
+
+    m_step = step;
+
+    if (m_icon)
+        DrawFaIconToLabel(m_icon, TypeToFaIcon(m_step->type()), m_fontAwesome);
+
+    update();
+}
+
+void StepWidget::setSelected(const bool selected)
+{
+    if (selected == m_selected)
+        return;
+
+    m_selected = selected;
+    update();
+}
+
 void StepWidget::onDelete(bool checked)
 {
     Q_UNUSED(checked);
@@ -106,6 +135,26 @@ int StepWidget::idealTypeLabelWidth()
     return maxWidth;
 }
 
+void StepWidget::paintSelection(QPainter &painter)
+{
+    if (!m_selected)
+        return;
+
+    QPen pen(palette().color(QPalette::Highlight), SelectionWidth);
+    pen.setJoinStyle(Qt::MiterJoin);
+    painter.setPen(pen);
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(rect().adjusted(SelectionWidth / 2, SelectionWidth / 2, -SelectionWidth / 2, -SelectionWidth / 2));
+}
+
+void StepWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        emit clicked(m_step, event->modifiers());
+
+    QWidget::mousePressEvent(event);
+}
+
 void StepWidget::contextMenuEvent(QContextMenuEvent *event)
 {
     if (!m_fontAwesome)
@@ -114,6 +163,13 @@ void StepWidget::contextMenuEvent(QContextMenuEvent *event)
         return;
     }
 
+    // A selected row's menu acts on the whole selection.
+    if (m_selected)
+    {
+        emit selectionMenuRequested(event->globalPos());
+        return;
+    }
+
     QMenu menu(this);
     QMenu *changeType = menu.addMenu(m_fontAwesome->faIcon(fa::cogs), "Change type");
     auto typeMap = AddTypesToMenu(changeType, m_fontAwesome);
@@ -145,6 +201,7 @@ IntervalWidget::IntervalWidget(Step *step, IFontAwesome *fontAwesome, QWidget *p
     , m_descriptionArea(nullptr)
     , m_descriptionLabel(nullptr)
     , m_textEdit(nullptr)
+    , m_textTimer(nullptr)
 {
     m_layout = new QHBoxLayout(this);
 
@@ -215,8 +272,14 @@ IntervalWidget::IntervalWidget(Step *step, IFontAwesome *fontAwesome, QWidget *p
 
     setLayout(m_layout);
 
+    m_textTimer = new QTimer(this);
+    m_textTimer->setSingleShot(true);
+    m_textTimer->setInterval(TextCommitDelay);
+    m_textEdit->installEventFilter(this);
+
     QObject::connect(m_timeEdit, SIGNAL(timeChanged(QTime)), this, SLOT(onTimeChanged(QTime)));
-    QObject::connect(m_textEdit, SIGNAL(textChanged()), this, SLOT(onTextChanged()));
+    QObject::connect(m_textEdit, SIGNAL(textChanged()), m_textTimer, SLOT(start()));
+    QObject::connect(m_textTimer, SIGNAL(timeout()), this, SLOT(onTextChanged()));
 }
 
 int IntervalWidget::idealHeight() const
@@ -224,6 +287,49 @@ int IntervalWidget::idealHeight() const
     return StepHeight;
 }
 
+void IntervalWidget::setStep(Step *step)
+{
+    // Anything worth keeping should have been committed by now, the old step may be gone.
+    discardEdits();
+
+    StepWidget::setStep(step);
+
+    m_title->setText(TypeToString(m_step->type()));
+
+    // Only the user's edits should reach the step.
+    QSignalBlocker blockTime(m_timeEdit);
+    QSignalBlocker blockText(m_textEdit);
+
+    QTime time(0,0);
+    time = time.addSecs(m_step->duration());
+    m_timeEdit->setTime(time);
+
+    Interval *interval = dynamic_cast<Interval*>(m_step);
+    m_textEdit->setText(interval ? interval->text() : QString());
+}
+
+void IntervalWidget::commitEdits()
+{
+    if (m_textTimer->isActive())
+    {
+        m_textTimer->stop();
+        onTextChanged();
+    }
+}
+
+void IntervalWidget::discardEdits()
+{
+    m_textTimer->stop();
+}
+
+bool IntervalWidget::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_textEdit && event->type() == QEvent::FocusOut)
+        commitEdits();
+
+    return StepWidget::eventFilter(watched, event);
+}
+
 void IntervalWidget::onTimeChanged(const QTime &time)
 {
     uint duration = (time.hour() * 3600) + (time.minute() * 60) + time.second();
@@ -246,6 +352,7 @@ void IntervalWidget::paintEvent(QPaintEvent *event)
     Q_UNUSED(event);
     QPainter painter(this);
     painter.fillRect(rect(), TypeToBgColour(m_step->type()));
+    paintSelection(painter);
 }
 
 LoopStepWidget::LoopStepWidget(Step *step, IFontAwesome *fontAwesome, QWidget *parent)
@@ -258,10 +365,19 @@ LoopStepWidget::LoopStepWidget(Step *step, IFontAwesome *fontAwesome, QWidget *p
     , m_addButtonArea(nullptr)
     , m_buttonLabel(nullptr)
     , m_addChildButton(nullptr)
+    , m_expandButton(nullptr)
 {
     m_topRow = new QWidget(this);
     m_topRowLayout = new QHBoxLayout(m_topRow);
 
+    LoopStep *loop = dynamic_cast<LoopStep*>(m_step);
+
+    // Expand/collapse toggle, collapsed loops don't create rows for (or load) their children
+    m_expandButton = new QPushButton(m_topRow);
+    m_expandButton->setFlat(true);
+    updateExpandButton();
+    m_topRowLayout->addWidget(m_expandButton);
+
     // Title/icon area
     m_titleArea = new QWidget(m_topRow);
 
@@ -291,7 +407,6 @@ LoopStepWidget::LoopStepWidget(Step *step, IFontAwesome *fontAwesome, QWidget *p
     m_spinBox = new QSpinBox(m_loopArea);
     m_spinBox->setFont(m_editFont);
     m_spinBox->setRange(1, 1000);
-    LoopStep *loop = dynamic_cast<LoopStep*>(m_step);
     if (loop)
         m_spinBox->setValue(loop->iterations());
 
@@ -331,70 +446,54 @@ LoopStepWidget::LoopStepWidget(Step *step, IFontAwesome *fontAwesome, QWidget *p
     adjustLayout();
 
     QObject::connect(m_addChildButton, SIGNAL(pressed()), this, SLOT(onAddChildPressed()));
+    QObject::connect(m_expandButton, SIGNAL(clicked(bool)), this, SLOT(onExpandPressed()), Qt::QueuedConnection);
     QObject::connect(m_spinBox, SIGNAL(valueChanged(int)), this, SLOT(onIterationsChanged(int)));
 }
 
 int LoopStepWidget::idealHeight() const
 {
-    int height = StepHeight;
-    for (auto child : m_children)
-    {
-        height += child->idealHeight() + LoopSpacing;
-    }
-    return height;
+    return StepHeight;
 }
 
-void LoopStepWidget::addChild(StepWidget *child)
+void LoopStepWidget::setStep(Step *step)
 {
-    m_children.push_back(child);
-    adjustLayout();
-}
+    StepWidget::setStep(step);
 
-void LoopStepWidget::onStepDeleted(Step *step)
-{
-    for (auto child : m_children)
-    {
-        if (child->step() == step)
-            child->hide();
-    }
+    updateExpandButton();
 
     LoopStep *loop = dynamic_cast<LoopStep*>(m_step);
-    if (!loop || !loop->deleteStep(step))
+    if (loop)
     {
-        Q_ASSERT(false);
+        QSignalBlocker blockIterations(m_spinBox);
+        m_spinBox->setValue(loop->iterations());
     }
 }
 
-void LoopStepWidget::onStepMovedUp(Step *step)
+void LoopStepWidget::updateExpandButton()
 {
     LoopStep *loop = dynamic_cast<LoopStep*>(m_step);
-    if (!loop || !loop->moveStepUp(step))
-    {
-        Q_ASSERT(false);
-    }
+    bool expanded = !loop || loop->expanded();
+    m_expandButton->setIcon(m_fontAwesome->faIcon(expanded ? fa::chevrondown : fa::chevronright));
+    m_expandButton->setToolTip(expanded ? "Collapse" : QString("Expand (%1 steps)").arg(m_step->getChildCount()));
 }
 
-void LoopStepWidget::onStepMovedDown(Step *step)
+void LoopStepWidget::onAddChildPressed()
 {
-    LoopStep *loop = dynamic_cast<LoopStep*>(m_step);
-    if (!loop || loop->moveStepDown(step))
-    {
-        Q_ASSERT(false);
-    }
+    QMetaObject::invokeMethod(window(), "onShowAddMenu", Qt::DirectConnection, Q_ARG(const QPoint, mapToGlobal(m_addChildButton->geometry().topRight())), Q_ARG(Step *, m_step));
 }
 
-void LoopStepWidget::onTypeChanged(Step *step, const StepType newType)
+void LoopStepWidget::onExpandPressed()
 {
     LoopStep *loop = dynamic_cast<LoopStep*>(m_step);
-    if (!loop || loop->changeType(step, newType))
+    if (!loop)
     {
         Q_ASSERT(false);
+        return;
     }
-}
 
-void LoopStepWidget::onAddChildPressed()
-{
-    QMetaObject::invokeMethod(window(), "onShowAddMenu", Qt::DirectConnection, Q_ARG(const QPoint, mapToGlobal(m_addChildButton->geometry().topRight())), Q_ARG(Step *, m_step));
+    loop->setExpanded(!loop->expanded());
+    updateExpandButton();
+    emit expandToggled(m_step);
 }
 
 void LoopStepWidget::onIterationsChanged(int iterations)
@@ -414,7 +513,7 @@ void LoopStepWidget::paintEvent(QPaintEvent *event)
     Q_UNUSED(event);
     QPainter painter(this);
     painter.fillRect(rect(), TypeToBgColour(StepType::Loop));
-    painter.fillRect(QRect(5, m_topRow->rect().bottom(), 3, height()), QColor(0x40, 0x40, 0x40));
+    paintSelection(painter);
 }
 
 void LoopStepWidget::resizeEvent(QResizeEvent *event)
@@ -425,18 +524,5 @@ void LoopStepWidget::resizeEvent(QResizeEvent *event)
 
 void LoopStepWidget::adjustLayout()
 {
-    static const int Spacing = 10;
-    static const int MarginLeft = 20;
-
-    QRect rect(0, 0, width(), StepHeight);
-    m_topRow->setGeometry(rect);
-
-    int y = m_topRow->height();
-
-    for (auto child : m_children)
-    {
-        rect.setRect(MarginLeft, y, width() - Spacing, child->idealHeight());
-        child->setGeometry(rect);
-        y += child->idealHeight() + Spacing;
-    }
+    m_topRow->setGeometry(0, 0, width(), StepHeight);
 }
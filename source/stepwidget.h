@@ -14,17 +14,22 @@
 #include <QSpinBox>
 #include <QPushButton>
 #include <QContextMenuEvent>
+#include <QTimer>
 
 #include "types.h"
 #include "ifontawesome.h"
 
 class Step;
+class QPainter;
 
 /*! Base Widget representing a Step object when setting up the turbo set */
 class StepWidget : public QWidget
 {
     Q_OBJECT
 public:
+    //! Height of a single row: an interval, or the header of a loop.
+    static const int RowHeight = 110;
+
     explicit StepWidget(Step *step, IFontAwesome *fontAwesome, QWidget *parent = nullptr);
 
     virtual int idealHeight() const = 0;
@@ -34,12 +39,34 @@ public:
         return m_step;
     }
 
+    //! Rebind the widget to a different step of the same kind, so widgets can be recycled.
+    virtual void setStep(Step *step);
+
+    //! Apply any edit still held back by the widget to its step.
+    virtual void commitEdits()
+    {
+    }
+
+    //! Drop any edit still held back, e.g. because the step is being deleted.
+    virtual void discardEdits()
+    {
+    }
+
+    //! Show whether the step is part of the staging area's selection.
+    void setSelected(const bool selected);
+
 signals:
     void deleted(Step *step);
     void movedUp(Step *step);
     void movedDown(Step *step);
     void typeChanged(Step *step, const StepType newType);
 
+    //! The row was clicked, with the modifiers deciding how the selection changes.
+    void clicked(Step *step, Qt::KeyboardModifiers modifiers);
+
+    //! The selected row's context menu was requested, for the whole selection.
+    void selectionMenuRequested(const QPoint &globalPos);
+
 protected slots:
     void onDelete(bool checked = false);
     void onMoveUp(bool checked = false);
@@ -50,9 +77,11 @@ protected:
     void initButtons();
 
     int idealTypeLabelWidth();
+    void paintSelection(QPainter &painter);
 
 protected: // Event handlers
     void contextMenuEvent(QContextMenuEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
 
 protected:
     Step            *m_step;
@@ -70,6 +99,7 @@ protected:
     QPushButton     *m_moveUp;
     QPushButton     *m_moveDown;
 
+    bool            m_selected;
 };
 
 /*! Represents an Interval object when setting up the turbo set */
@@ -81,12 +111,18 @@ public:
 
     int idealHeight() const override;
 
+    void setStep(Step *step) override;
+
+    void commitEdits() override;
+    void discardEdits() override;
+
 protected slots:
     void onTimeChanged(const QTime &time);
     void onTextChanged();
 
 protected: // Event handlers
     void paintEvent(QPaintEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 protected:
     QHBoxLayout *m_layout;
@@ -97,9 +133,13 @@ protected:
     QWidget     *m_descriptionArea;
     QLabel      *m_descriptionLabel;
     QTextEdit   *m_textEdit;
+    QTimer      *m_textTimer;   //!< Holds back typing until there's a pause.
 };
 
-/*! Represents a Loop object when setting up the turbo set, and is responsible for the layout of that Loop's child objects. */
+/*!
+ * Represents the header row of a Loop object when setting up the turbo set.
+ * The Loop's children are separate rows, laid out beneath it by the StagingArea.
+ */
 class LoopStepWidget : public StepWidget
 {
     Q_OBJECT
@@ -108,16 +148,14 @@ public:
 
     int idealHeight() const override;
 
-    void addChild(StepWidget *child);
+    void setStep(Step *step) override;
 
-public slots:
-    void onStepDeleted(Step *step);
-    void onStepMovedUp(Step *step);
-    void onStepMovedDown(Step *step);
-    void onTypeChanged(Step *step, const StepType newType);
+signals:
+    void expandToggled(Step *step);
 
 protected slots:
     void onAddChildPressed();
+    void onExpandPressed();
     void onIterationsChanged(int iterations);
 
 protected: // Event handlers
@@ -126,6 +164,7 @@ protected: // Event handlers
 
 protected:
     void adjustLayout();
+    void updateExpandButton();
 
 protected:
     QWidget     *m_topRow;
@@ -139,7 +178,7 @@ protected:
     QLabel      *m_buttonLabel;
     QPushButton *m_addChildButton;
 
-    QList<StepWidget*> m_children;
+    QPushButton *m_expandButton;
 };
 
 #endif // STEPCONTROL_H
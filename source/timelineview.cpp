@@ -0,0 +1,341 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "timelineview.h"
+#include "turbosetmodel.h"
+#include "stepresources.h"
+
+#include <QPainter>
+#include <QMouseEvent>
+#include <algorithm>
+#include <cmath>
+
+static const int DefaultHeight = 40;
+static const int MinMarkerSpacing = 4;     // Device pixels between step markers, closer ones are skipped
+static const QColor MarkerColour(0x33, 0x33, 0x33);
+
+static QColor BucketColour(const double *seconds, const int count)
+{
+    // The type playing for most of the column's time wins.
+    const double *dominant = std::max_element(seconds, seconds + count);
+    if (*dominant <= 0)
+        return QColor();
+
+    return TypeToBgColour((StepType)(dominant - seconds));
+}
+
+TimelineView::Summary::Summary()
+    : total(0)
+{
+    std::fill(seconds, seconds + TypeCount, 0.0);
+}
+
+void TimelineView::Summary::add(const Summary &other, const double multiplier)
+{
+    for (int i = 0; i < TypeCount; ++i)
+    {
+        seconds[i] += other.seconds[i] * multiplier;
+    }
+    total += other.total * multiplier;
+}
+
+TimelineView::TimelineView(TurboSetModel *model, QWidget *parent)
+    : QWidget(parent)
+    , m_model(model)
+    , m_totalSeconds(0)
+    , m_bucketSeconds(0)
+    , m_dirty(true)
+{
+    Q_ASSERT(model);
+
+    setCursor(Qt::PointingHandCursor);
+    setToolTip("The whole set, click to go to a step");
+
+    // Edits within a transaction only arrive as setModified once it's committed.
+    QObject::connect(m_model, SIGNAL(setChanged()), this, SLOT(onSetChanged()));
+    QObject::connect(m_model, SIGNAL(setModified()), this, SLOT(onSetChanged()));
+    QObject::connect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(onSetChanged()));
+}
+
+QSize TimelineView::sizeHint() const
+{
+    return QSize(QWidget::sizeHint().width(), DefaultHeight);
+}
+
+void TimelineView::onSetChanged()
+{
+    // Rebuilt when next painted, so a hidden timeline costs nothing.
+    m_dirty = true;
+    update();
+}
+
+void TimelineView::resizeEvent(QResizeEvent *event)
+{
+    Q_UNUSED(event);
+    m_dirty = true;
+}
+
+void TimelineView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    if (m_dirty)
+        rebuild();
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::Window));
+    painter.drawPixmap(0, 0, m_strip);
+}
+
+void TimelineView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        navigate(event->pos().x());
+}
+
+void TimelineView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton)
+        navigate(event->pos().x());
+}
+
+void TimelineView::rebuild()
+{
+    m_dirty = false;
+    m_summaries.clear();
+    m_starts.clear();
+
+    int columns = std::max(1, qRound(width() * devicePixelRatioF()));
+    m_buckets.assign(columns, Summary());
+
+    m_totalSeconds = 0;
+    std::vector<Step*> steps = m_model->getIntervals();
+    for (auto step : steps)
+    {
+        m_starts.push_back(m_totalSeconds);
+        m_totalSeconds += summarise(step).total;
+    }
+
+    m_bucketSeconds = m_totalSeconds / columns;
+
+    if (m_totalSeconds > 0)
+    {
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            addStep(steps[i], m_starts[i]);
+        }
+    }
+
+    render();
+}
+
+const TimelineView::Summary& TimelineView::summarise(Step *step)
+{
+    auto it = m_summaries.find(step);
+    if (it != m_summaries.end())
+        return *it;
+
+    Summary summary;
+    LoopStep *loop = dynamic_cast<LoopStep*>(step);
+
+    if (!loop)
+    {
+        summary.seconds[(int)step->type()] = step->duration();
+        summary.total = step->duration();
+    }
+    else if (!loop->isMaterialised())
+    {
+        // Don't parse a lazy loop just for the overview, show it as a single block.
+        summary.seconds[(int)StepType::Loop] = (double)loop->playedDuration();
+        summary.total = summary.seconds[(int)StepType::Loop];
+    }
+    else
+    {
+        for (size_t i = 0; i < loop->getChildCount(); ++i)
+        {
+            summary.add(summarise(loop->getChild(i)));
+        }
+
+        Summary iteration = summary;
+        summary = Summary();
+        summary.add(iteration, loop->playedIterations());
+    }
+
+    return *m_summaries.insert(step, summary);
+}
+
+void TimelineView::addStep(Step *step, const double start)
+{
+    const Summary summary = summarise(step);
+    if (summary.total <= 0)
+        return;
+
+    // Anything that fits in one column is added as a whole, however much it contains.
+    int bucket = bucketAt(start);
+    if (start + summary.total <= (bucket + 1) * m_bucketSeconds)
+    {
+        m_buckets[bucket].add(summary);
+        return;
+    }
+
+    LoopStep *loop = dynamic_cast<LoopStep*>(step);
+    if (!loop || !loop->isMaterialised())
+    {
+        addInterval(loop ? StepType::Loop : step->type(), start, summary.total);
+        return;
+    }
+
+    double iterations = loop->playedIterations();
+    double length = summary.total / iterations;
+
+    for (double i = 0; i < iterations; )
+    {
+        double iterationStart = start + (i * length);
+        bucket = bucketAt(iterationStart);
+
+        // Whole iterations within this column are added together.
+        double fit = std::min(iterations - i, std::floor((((bucket + 1) * m_bucketSeconds) - iterationStart) / length));
+        if (fit >= 1)
+        {
+            m_buckets[bucket].add(summary, fit / iterations);
+            i += fit;
+            continue;
+        }
+
+        // This iteration crosses into the next column, so its children are placed separately.
+        double childStart = iterationStart;
+        for (size_t c = 0; c < loop->getChildCount(); ++c)
+        {
+            Step *child = loop->getChild(c);
+            addStep(child, childStart);
+            childStart += summarise(child).total;
+        }
+        ++i;
+    }
+}
+
+void TimelineView::addInterval(const StepType type, const double start, const double duration)
+{
+    double end = start + duration;
+    int last = bucketAt(end);
+
+    for (int bucket = bucketAt(start); bucket <= last; ++bucket)
+    {
+        double overlap = std::min(end, (bucket + 1) * m_bucketSeconds) - std::max(start, bucket * m_bucketSeconds);
+        if (overlap <= 0)
+            continue;
+
+        m_buckets[bucket].seconds[(int)type] += overlap;
+        m_buckets[bucket].total += overlap;
+    }
+}
+
+void TimelineView::render()
+{
+    qreal ratio = devicePixelRatioF();
+    int columns = (int)m_buckets.size();
+    int height = std::max(1, qRound(this->height() * ratio));
+
+    m_strip = QPixmap(columns, height);
+    m_strip.fill(palette().color(QPalette::Window));
+
+    QPainter painter(&m_strip);
+
+    // Neighbouring columns of the same colour are filled together.
+    int runStart = 0;
+    QColor runColour;
+    for (int i = 0; i <= columns; ++i)
+    {
+        QColor colour = (i < columns) ? BucketColour(m_buckets[i].seconds, TypeCount) : QColor();
+        if (i > 0 && colour == runColour)
+            continue;
+
+        if (runColour.isValid())
+            painter.fillRect(runStart, 0, i - runStart, height, runColour);
+
+        runStart = i;
+        runColour = colour;
+    }
+
+    // Mark where each top-level step starts, while there's room to tell them apart.
+    if (m_bucketSeconds > 0)
+    {
+        painter.setPen(MarkerColour);
+        int lastMarker = -MinMarkerSpacing;
+        for (double start : m_starts)
+        {
+            int x = (int)(start / m_bucketSeconds);
+            if (x - lastMarker < MinMarkerSpacing)
+                continue;
+
+            painter.drawLine(x, 0, x, height - 1);
+            lastMarker = x;
+        }
+    }
+
+    painter.end();
+    m_strip.setDevicePixelRatio(ratio);
+}
+
+int TimelineView::bucketAt(const double time) const
+{
+    if (m_bucketSeconds <= 0)
+        return 0;
+
+    return qBound(0, (int)(time / m_bucketSeconds), (int)m_buckets.size() - 1);
+}
+
+Step* TimelineView::stepAt(const double time) const
+{
+    auto it = std::upper_bound(m_starts.begin(), m_starts.end(), time);
+    if (it == m_starts.begin())
+        return nullptr;
+
+    size_t index = (it - m_starts.begin()) - 1;
+    Step *step = m_model->childAt(nullptr, index);
+    double offset = time - m_starts[index];
+
+    // Work down through the loops to the step playing at that time.
+    LoopStep *loop = dynamic_cast<LoopStep*>(step);
+    while (loop && loop->isMaterialised())
+    {
+        double length = m_summaries.value(loop).total / loop->playedIterations();
+        if (length <= 0)
+            break;
+
+        offset = std::fmod(offset, length);
+
+        Step *child = nullptr;
+        for (size_t c = 0; c < loop->getChildCount() && !child; ++c)
+        {
+            double childLength = m_summaries.value(loop->getChild(c)).total;
+            if (offset < childLength)
+                child = loop->getChild(c);
+            else
+                offset -= childLength;
+        }
+
+        if (!child)
+            break;
+
+        step = child;
+        loop = dynamic_cast<LoopStep*>(step);
+    }
+
+    return step;
+}
+
+void TimelineView::navigate(const int x)
+{
+    if (m_dirty)
+        rebuild();
+
+    if (m_totalSeconds <= 0)
+        return;
+
+    double time = (x + 0.5) * devicePixelRatioF() * m_bucketSeconds;
+    Step *step = stepAt(time);
+    if (step)
+        emit stepClicked(step);
+}
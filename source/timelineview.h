@@ -0,0 +1,83 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef TIMELINEVIEW_H
+#define TIMELINEVIEW_H
+
+#include <QWidget>
+#include <QHash>
+#include <QPixmap>
+#include <vector>
+
+#include "types.h"
+
+class Step;
+class TurboSetModel;
+
+/*!
+ * An overview of the whole set as a strip of coloured blocks, each as long as the time
+ * it plays for, with loops expanded by their iterations. Clicking (or dragging along)
+ * the strip navigates to the step playing at that point.
+ *
+ * The strip is built as one bucket per device pixel column, each coloured by the type
+ * of step that plays for most of its time. Runs of steps or loop iterations that fall
+ * within a single column are added to it as a whole from a summary of their types, so
+ * building costs in proportion to the width rather than the number of intervals played.
+ */
+class TimelineView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit TimelineView(TurboSetModel *model, QWidget *parent = nullptr);
+
+    QSize sizeHint() const override;
+
+signals:
+    void stepClicked(Step *step);
+
+protected slots:
+    void onSetChanged();
+
+protected: // Event handlers
+    void resizeEvent(QResizeEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+protected:
+    static const int TypeCount = (int)StepType::Loop + 1;
+
+    /*! Seconds played of each type of step */
+    struct Summary
+    {
+        Summary();
+
+        void add(const Summary &other, const double multiplier = 1.0);
+
+        double seconds[TypeCount];
+        double total;
+    };
+
+    void rebuild();
+    const Summary& summarise(Step *step);
+    void addStep(Step *step, const double start);
+    void addInterval(const StepType type, const double start, const double duration);
+    void render();
+
+    int bucketAt(const double time) const;
+    Step* stepAt(const double time) const;
+    void navigate(const int x);
+
+protected:
+    TurboSetModel *m_model;
+    QHash<Step*, Summary> m_summaries;      //!< Per step, for loops all of the iterations played.
+    std::vector<Summary> m_buckets;
+    std::vector<double> m_starts;           //!< Start of each top-level step, in seconds.
+    double m_totalSeconds;
+    double m_bucketSeconds;
+    QPixmap m_strip;
+    bool m_dirty;
+};
+
+#endif // TIMELINEVIEW_H
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+#####################################
+# Copyright (C) 2017 Michael Pearce #
+#####################################
+
+"""
+Subsets the FontAwesome font down to the glyphs the application references.
+
+Every fa::<name> in the application's sources is resolved to its code-point
+using the enum in QtAwesome.h, and pyftsubset (from fontTools) writes a font
+containing just those glyphs. A resource file is written next to it, aliasing
+the subset to the path initFontAwesome() loads the full font from.
+
+Usage: subset_icon_font.py <source dir> <font> <output dir>
+"""
+
+import os
+import re
+import subprocess
+import sys
+
+ICON_REFERENCE = re.compile(r'\bfa::(\w+)')
+ENUM_ENTRY = re.compile(r'^\s*(\w+)\s*=\s*(0x[0-9a-fA-F]+)', re.MULTILINE)
+
+SUBSET_NAME = 'fontawesome-subset.ttf'
+RESOURCE_NAME = 'QtAwesome.qrc'
+RESOURCE_ALIAS = 'fonts/fontawesome-4.7.0.ttf'
+
+
+def read_codepoints(header):
+    with open(header, encoding='utf-8') as f:
+        text = f.read()
+    start = text.index('namespace fa {')
+    end = text.index('};', start)
+    return {name: int(value, 16) for name, value in ENUM_ENTRY.findall(text[start:end])}
+
+
+def find_icons(source_dir):
+    icons = set()
+    for root, dirs, files in os.walk(source_dir):
+        # QtAwesome itself mentions every icon
+        dirs[:] = [d for d in dirs if d != 'QtAwesome']
+        for name in files:
+            if name.endswith(('.cpp', '.h')):
+                with open(os.path.join(root, name), encoding='utf-8', errors='replace') as f:
+                    icons.update(ICON_REFERENCE.findall(f.read()))
+    return icons
+
+
+def write_if_changed(path, content):
+    # Leaves the timestamp alone when nothing changed, so rcc doesn't run again
+    if os.path.exists(path):
+        with open(path, encoding='utf-8') as f:
+            if f.read() == content:
+                return
+    with open(path, 'w', encoding='utf-8') as f:
+        f.write(content)
+
+
+def main(argv):
+    if len(argv) != 4:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 2
+
+    source_dir, font, output_dir = argv[1:]
+    codepoints = read_codepoints(os.path.join(source_dir, 'QtAwesome', 'QtAwesome.h'))
+
+    icons = find_icons(source_dir)
+    unknown = sorted(icons - set(codepoints))
+    if unknown:
+        print('Unknown icons: ' + ', '.join(unknown), file=sys.stderr)
+        return 1
+
+    unicodes = ','.join('U+%04X' % codepoints[icon] for icon in sorted(icons))
+    os.makedirs(output_dir, exist_ok=True)
+
+    subset = os.path.join(output_dir, SUBSET_NAME)
+    result = subprocess.call(['pyftsubset', font,
+                              '--unicodes=' + unicodes,
+                              '--output-file=' + subset,
+                              '--layout-features=',
+                              '--no-hinting',
+                              '--desubroutinize'])
+    if result != 0:
+        return result
+
+    write_if_changed(os.path.join(output_dir, RESOURCE_NAME),
+                     '<RCC>\n'
+                     '    <qresource prefix="/">\n'
+                     '        <file alias="%s">%s</file>\n'
+                     '    </qresource>\n'
+                     '</RCC>\n' % (RESOURCE_ALIAS, SUBSET_NAME))
+
+    print('Subset %s to %d glyphs' % (os.path.basename(font), len(icons)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
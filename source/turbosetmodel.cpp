@@ -3,12 +3,14 @@
  *************************************/
 
 #include "turbosetmodel.h"
+#include "lazysetloader.h"
 #include <QFile>
+#include <QSaveFile>
 #include <QDomDocument>
-#include <QTextStream>
 #include <QTimer>
 #include <QTimerEvent>
 #include <climits>
+#include <algorithm>
 
 const QString TurboSetModel::TurboSetTag    = "TurboSet";
 const QString TurboSetModel::IntervalTag    = "interval";
@@ -18,14 +20,30 @@ const QString TurboSetModel::TextAttr       = "text";
 const QString TurboSetModel::DurationAttr   = "duration";
 const QString TurboSetModel::IterationsAttr = "iterations";
 
+//! Seconds a step takes to play, with its loops expanded.
+static int64_t PlayedDuration(Step *step)
+{
+    // A lazy loop isn't loaded just to time it, the played duration skimmed from its body will do.
+    LoopStep *loop = dynamic_cast<LoopStep*>(step);
+    return loop ? (int64_t)loop->playedDuration() : step->duration();
+}
+
 TurboSetModel::TurboSetModel(QObject *parent)
-    : QAbstractListModel(parent)
+    : QAbstractItemModel(parent)
     , m_dirty(false)
+    , m_revision(0)
+    , m_loadMode(LoadMode::Eager)
+    , m_resetting(false)
+    , m_materialising(false)
+    , m_transactionDepth(0)
+    , m_pendingModified(false)
     , m_currentStep(nullptr)
     , m_currentInterval(nullptr)
     , m_nextInterval(nullptr)
-    , m_playbackState(PlaybackState::Ready)
     , m_timeRemaining(-1)
+    , m_setElapsed(0)
+    , m_setDuration(0)
+    , m_playbackState(PlaybackState::Ready)
 {
     m_timer = new QTimer(this);
     QObject::connect(m_timer, SIGNAL(timeout()), this, SLOT(onStepFinished()));
@@ -36,8 +54,19 @@ std::vector<Step *> TurboSetModel::getIntervals() const
     return m_steps;
 }
 
+Step* TurboSetModel::childAt(Step *parent, size_t index) const
+{
+    if (parent)
+        return index < parent->getChildCount() ? parent->getChild(index) : nullptr;
+
+    return index < m_steps.size() ? m_steps[index] : nullptr;
+}
+
 void TurboSetModel::addStep(StepType type, Step *parent)
 {
+    if (!isEditable())
+        return;
+
     Step *step = nullptr;
     if (type == StepType::Loop)
     {
@@ -62,42 +91,222 @@ void TurboSetModel::addStep(StepType type, Step *parent)
             Q_ASSERT(false);
             return;
         }
+        // Views must have the existing children before one can be added.
+        QModelIndex loopIndex = indexForStep(loop);
+        if (canFetchMore(loopIndex))
+            fetchMore(loopIndex);
+
+        bool wasExpanded = loop->expanded();
+        loop->setExpanded(true);
+
+        size_t index = loop->getChildCount();
+        notifyAboutToInsert(loop, index);
         loop->addChild(step);
+        notifyInserted(loop, index);
+
+        if (!wasExpanded)
+            notifyUpdated(loop);
     }
     else
     {
+        notifyAboutToInsert(nullptr, m_steps.size());
         m_steps.push_back(step);
+        notifyInserted(nullptr, m_steps.size() - 1);
     }
+}
 
-    m_dirty = true;
-    emit setChanged();
+Step* TurboSetModel::stepForIndex(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return nullptr;
+
+    return static_cast<Step*>(index.internalPointer());
+}
+
+QModelIndex TurboSetModel::indexForStep(Step *step) const
+{
+    if (!step)
+        return QModelIndex();
+
+    size_t row = SIZE_MAX;
+    if (step->parent())
+    {
+        row = step->parent()->indexOf(step);
+    }
+    else
+    {
+        auto it = std::find(m_steps.begin(), m_steps.end(), step);
+        if (it != m_steps.end())
+            row = it - m_steps.begin();
+    }
+
+    if (row == SIZE_MAX)
+        return QModelIndex(); // Not part of the set (yet)
+
+    return createIndex((int)row, 0, step);
+}
+
+QModelIndex TurboSetModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (row < 0 || column != 0 || row >= rowCount(parent))
+        return QModelIndex();
+
+    return createIndex(row, column, childAt(stepForIndex(parent), row));
+}
+
+QModelIndex TurboSetModel::parent(const QModelIndex &child) const
+{
+    Step *step = stepForIndex(child);
+    if (!step)
+        return QModelIndex();
+
+    return indexForStep(step->parent());
 }
 
 int TurboSetModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0)
+        return 0;
+
+    Step *step = stepForIndex(parent);
+    if (!step)
+        return (int)m_steps.size();
+
+    // Lazily-loaded loops report no rows until they've been fetched.
+    LoopStep *loop = dynamic_cast<LoopStep*>(step);
+    if (!loop || !loop->isMaterialised())
+        return 0;
+
+    return (int)loop->getChildCount();
+}
+
+int TurboSetModel::columnCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return (int)m_steps.size();
+    return 1;
+}
+
+bool TurboSetModel::hasChildren(const QModelIndex &parent) const
+{
+    Step *step = stepForIndex(parent);
+    if (!step)
+        return !m_steps.empty();
+
+    return step->type() == StepType::Loop && step->getChildCount() > 0;
+}
+
+bool TurboSetModel::canFetchMore(const QModelIndex &parent) const
+{
+    LoopStep *loop = dynamic_cast<LoopStep*>(stepForIndex(parent));
+    return loop && !loop->isMaterialised() && loop->getChildCount() > 0;
+}
+
+void TurboSetModel::fetchMore(const QModelIndex &parent)
+{
+    LoopStep *loop = dynamic_cast<LoopStep*>(stepForIndex(parent));
+    if (!loop || loop->isMaterialised())
+        return;
+
+    // The loop reports the new rows, see notifyAboutToMaterialise().
+    loop->materialise();
 }
 
 QVariant TurboSetModel::data(const QModelIndex &index, int role) const
 {
-    Q_UNUSED(index);
-    Q_UNUSED(role);
+    Step *step = stepForIndex(index);
+    if (!step)
+        return QVariant();
+
+    LoopStep *loop = dynamic_cast<LoopStep*>(step);
+    Interval *interval = dynamic_cast<Interval*>(step);
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        if (loop)
+            return QString("Repeat x%1").arg(loop->iterations());
+        return interval ? interval->text() : QVariant();
+    case Qt::EditRole:
+        if (loop)
+            return loop->iterations();
+        return interval ? interval->text() : QVariant();
+    case TypeRole:
+        return (int)step->type();
+    case DurationRole:
+        return step->duration();
+    case TextRole:
+        return interval ? interval->text() : QVariant();
+    case IterationsRole:
+        return loop ? loop->iterations() : QVariant();
+    default:
+        break;
+    }
+
     return QVariant();
 }
 
+bool TurboSetModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    Step *step = stepForIndex(index);
+    if (!step || !isEditable())
+        return false;
+
+    LoopStep *loop = dynamic_cast<LoopStep*>(step);
+    Interval *interval = dynamic_cast<Interval*>(step);
+
+    if (role == Qt::EditRole)
+        role = loop ? IterationsRole : TextRole;
+
+    if (role == DurationRole && interval)
+        interval->setDuration(value.toUInt());
+    else if (role == TextRole && interval)
+        interval->setText(value.toString());
+    else if (role == IterationsRole && loop && value.toUInt() > 0)
+        loop->setIterations(value.toUInt());
+    else
+        return false;
+
+    // The setters have already reported the change to views of the item model.
+    emit stepUpdated(step);
+    return true;
+}
+
+Qt::ItemFlags TurboSetModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+
+    if (!isEditable())
+        return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
+}
+
 bool TurboSetModel::serialise(const QString &file)
 {
     if (file.isEmpty())
         return true;
 
-    QFile xmlFile(file);
+    // QSaveFile writes to a temporary file and renames it over the target on commit(),
+    // so an interrupted save can never leave a truncated set behind.
+    QSaveFile xmlFile(file);
     if (!xmlFile.open(QIODevice::WriteOnly))
     {
         Q_ASSERT(false);
         return false;
     }
 
+    xmlFile.write(toXml());
+
+    if (!xmlFile.commit())
+        return false;
+
+    m_dirty = false;
+    return true;
+}
+
+QByteArray TurboSetModel::toXml() const
+{
     QDomDocument doc(TurboSetTag);
     QDomElement root = doc.createElement(TurboSetTag);
     for (auto step : m_steps)
@@ -106,13 +315,7 @@ bool TurboSetModel::serialise(const QString &file)
     }
     doc.appendChild(root);
 
-    QTextStream ts(&xmlFile);
-    ts << doc.toString();
-
-    xmlFile.close();
-
-    m_dirty = false;
-    return true;
+    return doc.toByteArray();
 }
 
 bool TurboSetModel::deserialise(const QString &file)
@@ -120,7 +323,9 @@ bool TurboSetModel::deserialise(const QString &file)
     if (file.isEmpty())
         return true;
 
+    beginResetModel();
     clearSet();
+    endResetModel();
 
     QFile xmlFile(file);
     if (!xmlFile.open(QIODevice::ReadOnly))
@@ -129,15 +334,51 @@ bool TurboSetModel::deserialise(const QString &file)
         return false;
     }
 
+    QByteArray data = xmlFile.readAll();
+    xmlFile.close();
+
+    if (m_loadMode == LoadMode::Lazy && loadLazy(data))
+        return true;
+
     QDomDocument doc(TurboSetTag);
-    if (!doc.setContent(&xmlFile))
+    if (!doc.setContent(data))
     {
-        xmlFile.close();
         Q_ASSERT(false);
         return false;
     }
 
-    xmlFile.close();
+    fromDocument(doc);
+
+    return true;
+}
+
+bool TurboSetModel::fromXml(const QByteArray &data, QString *errorMsg /*= nullptr*/)
+{
+    QDomDocument doc(TurboSetTag);
+    QString error;
+    int line = 0;
+    if (!doc.setContent(data, &error, &line))
+    {
+        if (errorMsg)
+            *errorMsg = QString("line %1: %2").arg(line).arg(error);
+        return false;
+    }
+
+    fromDocument(doc);
+
+    return true;
+}
+
+void TurboSetModel::fromDocument(const QDomDocument &doc)
+{
+    Transaction transaction(*this);
+
+    beginResetModel();
+    m_resetting = true;
+
+    clearSet();
+
+    ++m_revision;
 
     QDomElement root = doc.documentElement();
 
@@ -150,16 +391,73 @@ bool TurboSetModel::deserialise(const QString &file)
     }
 
     m_dirty = false;
+    m_pendingModified = false; // Loading isn't a modification
+
+    m_resetting = false;
+    endResetModel();
+
+    emit setChanged();
+}
+
+bool TurboSetModel::loadLazy(const QByteArray &data)
+{
+    LazySetSourcePtr source(new LazySetSource(data));
+    std::vector<Step*> steps;
+
+    if (!LazySetLoader::loadSet(source, this, steps))
+    {
+        for (auto step : steps)
+        {
+            delete step;
+        }
+        return false;
+    }
+
+    Transaction transaction(*this);
+
+    beginResetModel();
+    clearSet();
+    ++m_revision;
+
+    m_steps = steps;
+    m_dirty = false;
+    m_pendingModified = false;
+    endResetModel();
 
     emit setChanged();
 
     return true;
 }
 
+void TurboSetModel::adoptSteps(const std::vector<Step*> &steps)
+{
+    beginResetModel();
+    clearSet();
+
+    m_steps = steps;
+    markDirty();
+    endResetModel();
+
+    emit setChanged();
+}
+
+void TurboSetModel::setLoadMode(const LoadMode mode)
+{
+    m_loadMode = mode;
+}
+
+TurboSetModel::LoadMode TurboSetModel::loadMode() const
+{
+    return m_loadMode;
+}
+
 bool TurboSetModel::newSet()
 {
+    beginResetModel();
     clearSet();
-    m_dirty = true;
+    markDirty();
+    endResetModel();
+
     emit setChanged();
     return true;
 }
@@ -169,11 +467,223 @@ bool TurboSetModel::dirty() const
     return m_dirty;
 }
 
+void TurboSetModel::markDirty()
+{
+    m_dirty = true;
+    ++m_revision;
+
+    if (m_transactionDepth > 0)
+        m_pendingModified = true;
+    else
+        emit setModified();
+}
+
+quint64 TurboSetModel::revision() const
+{
+    return m_revision;
+}
+
+void TurboSetModel::beginTransaction()
+{
+    ++m_transactionDepth;
+}
+
+void TurboSetModel::commitTransaction()
+{
+    if (m_transactionDepth <= 0)
+    {
+        Q_ASSERT(false);
+        return;
+    }
+
+    if (--m_transactionDepth > 0)
+        return;
+
+    for (auto step : m_pendingChanged)
+    {
+        QModelIndex index = indexForStep(step);
+        if (index.isValid())
+            emit dataChanged(index, index);
+    }
+    m_pendingChanged.clear();
+
+    if (m_pendingModified)
+    {
+        m_pendingModified = false;
+        emit setModified();
+    }
+
+    emit transactionCommitted();
+}
+
+bool TurboSetModel::inTransaction() const
+{
+    return m_transactionDepth > 0;
+}
+
 bool TurboSetModel::isEmpty() const
 {
     return m_steps.empty();
 }
 
+bool TurboSetModel::isEditable() const
+{
+    return m_playbackState == PlaybackState::Ready;
+}
+
+void TurboSetModel::scaleDurations(const std::vector<Step*> &steps, const double factor)
+{
+    if (!isEditable())
+        return;
+
+    Transaction transaction(*this);
+
+    // Loops are scaled by scaling everything inside them.
+    std::vector<Step*> pending = outermostSteps(steps);
+    QSet<LoopStep*> loops;
+    while (!pending.empty())
+    {
+        Step *step = pending.back();
+        pending.pop_back();
+
+        if (LoopStep *loop = dynamic_cast<LoopStep*>(step))
+        {
+            for (size_t i = 0; i < loop->getChildCount(); ++i)
+            {
+                pending.push_back(loop->getChild(i));
+            }
+            continue;
+        }
+
+        unsigned int duration = (unsigned int)std::max(qRound(step->duration() * factor), 1);
+        if (duration == step->duration())
+            continue;
+
+        step->setDuration(duration);
+        notifyUpdated(step);
+
+        for (LoopStep *loop = step->parent(); loop; loop = loop->parent())
+        {
+            loops.insert(loop);
+        }
+    }
+
+    // The loops' durations have changed with their children's.
+    for (LoopStep *loop : loops)
+    {
+        notifyDataChanged(loop);
+    }
+}
+
+void TurboSetModel::changeTypes(const std::vector<Step*> &steps, const StepType newType)
+{
+    if (!isEditable())
+        return;
+
+    Transaction transaction(*this);
+
+    for (auto step : outermostSteps(steps))
+    {
+        if (step->type() != newType)
+            onTypeChanged(step, newType);
+    }
+}
+
+void TurboSetModel::deleteSteps(const std::vector<Step*> &steps)
+{
+    if (!isEditable())
+        return;
+
+    Transaction transaction(*this);
+
+    for (auto step : outermostSteps(steps))
+    {
+        onStepDeleted(step);
+    }
+}
+
+LoopStep* TurboSetModel::wrapInLoop(const std::vector<Step*> &steps)
+{
+    if (!isEditable())
+        return nullptr;
+
+    std::vector<Step*> wrapped = outermostSteps(steps);
+    if (!areSiblings(wrapped))
+    {
+        Q_ASSERT(false);
+        return nullptr;
+    }
+
+    // Look each position up once, rather than on every comparison.
+    std::vector<std::pair<size_t, Step*> > ordered;
+    for (auto step : wrapped)
+    {
+        ordered.push_back(std::make_pair(indexOf(step), step));
+    }
+    std::sort(ordered.begin(), ordered.end());
+
+    for (size_t i = 0; i < ordered.size(); ++i)
+    {
+        wrapped[i] = ordered[i].second;
+    }
+
+    Transaction transaction(*this);
+
+    LoopStep *parent = wrapped.front()->parent();
+    LoopStep *loop = new LoopStep(this);
+    insertStep(parent, indexOf(wrapped.front()), loop);
+
+    for (auto step : wrapped)
+    {
+        takeStep(step);
+        loop->insertChild(loop->getChildCount(), step);
+    }
+
+    loop->setIterations(1);
+    return loop;
+}
+
+void TurboSetModel::unwrapLoops(const std::vector<Step*> &steps)
+{
+    if (!isEditable())
+        return;
+
+    Transaction transaction(*this);
+
+    for (auto step : outermostSteps(steps))
+    {
+        LoopStep *loop = dynamic_cast<LoopStep*>(step);
+        if (!loop)
+            continue;
+
+        // The children go after the loop, in order, then the empty loop goes.
+        LoopStep *parent = loop->parent();
+        size_t index = indexOf(loop);
+        size_t children = loop->getChildCount();
+        for (size_t i = 0; i < children; ++i)
+        {
+            insertStep(parent, index + 1 + i, loop->takeChild(0));
+        }
+
+        onStepDeleted(loop);
+    }
+}
+
+bool TurboSetModel::areSiblings(const std::vector<Step*> &steps)
+{
+    std::vector<Step*> outermost = outermostSteps(steps);
+    if (outermost.empty())
+        return false;
+
+    LoopStep *parent = outermost.front()->parent();
+    for (auto step : outermost)
+    {
+        if (step->parent() != parent)
+            return false;
+    }
+    return true;
+}
+
 void TurboSetModel::startSet()
 {
     if (m_steps.empty())
@@ -189,6 +699,13 @@ void TurboSetModel::startSet()
         m_currentInterval = nullptr;
         m_nextInterval = nullptr;
 
+        m_setElapsed = 0;
+        m_setDuration = 0;
+        for (auto step : m_steps)
+        {
+            m_setDuration += PlayedDuration(step) * 1000;
+        }
+
         emit setStarted();
     }
     else
@@ -235,11 +752,93 @@ void TurboSetModel::togglePlayPause()
 
 void TurboSetModel::notifyChange(bool redrawNeeded /*= false*/)
 {
-    m_dirty = true;
+    markDirty();
     if (redrawNeeded)
         emit setChanged();
 }
 
+void TurboSetModel::notifyAboutToInsert(Step *parent, size_t index)
+{
+    beginInsertRows(indexForStep(parent), (int)index, (int)index);
+}
+
+void TurboSetModel::notifyInserted(Step *parent, size_t index)
+{
+    endInsertRows();
+    markDirty();
+    emit stepInserted(parent, (int)index);
+}
+
+void TurboSetModel::notifyAboutToRemove(Step *parent, size_t index)
+{
+    if (!m_pendingChanged.isEmpty())
+        forgetPendingChanges(childAt(parent, index));
+
+    beginRemoveRows(indexForStep(parent), (int)index, (int)index);
+    emit stepAboutToBeRemoved(parent, (int)index);
+}
+
+void TurboSetModel::notifyRemoved(Step *parent, size_t index)
+{
+    endRemoveRows();
+    markDirty();
+    emit stepRemoved(parent, (int)index);
+}
+
+void TurboSetModel::notifyAboutToMove(Step *parent, size_t from, size_t to)
+{
+    // Qt wants the row the moved row ends up in front of.
+    QModelIndex parentIndex = indexForStep(parent);
+    beginMoveRows(parentIndex, (int)from, (int)from, parentIndex, (int)(to > from ? to + 1 : to));
+}
+
+void TurboSetModel::notifyMoved(Step *parent, size_t from, size_t to)
+{
+    endMoveRows();
+    markDirty();
+    emit stepMoved(parent, (int)from, (int)to);
+}
+
+void TurboSetModel::notifyAboutToMaterialise(Step *loop, size_t childCount)
+{
+    // Loops are also materialised by playback and the staging area, not only by fetchMore().
+    m_materialising = !m_resetting && childCount > 0;
+    if (m_materialising)
+        beginInsertRows(indexForStep(loop), 0, (int)childCount - 1);
+}
+
+void TurboSetModel::notifyMaterialised(Step *loop)
+{
+    Q_UNUSED(loop);
+    if (m_materialising)
+        endInsertRows();
+    m_materialising = false;
+}
+
+void TurboSetModel::notifyDataChanged(Step *step)
+{
+    markDirty();
+
+    if (m_resetting)
+        return;
+
+    if (m_transactionDepth > 0)
+    {
+        m_pendingChanged.insert(step);
+        return;
+    }
+
+    QModelIndex index = indexForStep(step);
+    if (index.isValid())
+        emit dataChanged(index, index);
+}
+
+void TurboSetModel::notifyUpdated(Step *step)
+{
+    notifyDataChanged(step);
+    emit stepUpdated(step);
+}
+
 Interval* TurboSetModel::currentInterval()
 {
     return m_currentInterval;
@@ -255,17 +854,46 @@ bool TurboSetModel::currentIteration(uint32_t &current, uint32_t &total)
     return (m_currentStep) ? m_currentStep->currentIteration(current, total) : false;
 }
 
+bool TurboSetModel::playbackProgress(PlaybackProgress &progress)
+{
+    if (m_playbackState == PlaybackState::Ready || !m_currentInterval || !m_timer)
+        return false;
+
+    // While paused the timer is stopped, and the time it had left has been kept.
+    int64_t remaining = (m_playbackState == PlaybackState::Playing) ? m_timer->remainingTime() : m_timeRemaining;
+
+    progress.intervalDuration = (int64_t)m_currentInterval->duration() * 1000;
+    progress.intervalElapsed = qBound<int64_t>(0, progress.intervalDuration - remaining, progress.intervalDuration);
+    progress.setDuration = m_setDuration;
+    progress.setElapsed = std::min(m_setElapsed + progress.intervalElapsed, m_setDuration);
+    return true;
+}
+
 void TurboSetModel::onStepDeleted(Step *step)
 {
+    if (!isEditable())
+        return;
+
+    if (step->parent())
+    {
+        if (!step->parent()->deleteStep(step))
+            Q_ASSERT(false);
+        return;
+    }
+
     auto it = m_steps.begin();
     while (it != m_steps.end())
     {
         Step *child = *it;
         if (child == step)
         {
+            size_t index = it - m_steps.begin();
+            notifyAboutToRemove(nullptr, index);
+
             delete child;
             m_steps.erase(it);
-            emit setChanged();
+
+            notifyRemoved(nullptr, index);
             return;
         }
 
@@ -275,6 +903,15 @@ void TurboSetModel::onStepDeleted(Step *step)
 
 void TurboSetModel::onStepMovedUp(Step *step)
 {
+    if (!isEditable())
+        return;
+
+    if (step->parent())
+    {
+        step->parent()->moveStepUp(step);
+        return;
+    }
+
     if (m_steps.empty())
     {
         Q_ASSERT(false);
@@ -300,13 +937,22 @@ void TurboSetModel::onStepMovedUp(Step *step)
         return;
     }
 
+    notifyAboutToMove(nullptr, cur, prev);
     std::iter_swap(m_steps.begin() + cur, m_steps.begin() + prev);
-
-    emit setChanged();
+    notifyMoved(nullptr, cur, prev);
 }
 
 void TurboSetModel::onStepMovedDown(Step *step)
 {
+    if (!isEditable())
+        return;
+
+    if (step->parent())
+    {
+        step->parent()->moveStepDown(step);
+        return;
+    }
+
     if (m_steps.empty())
     {
         Q_ASSERT(false);
@@ -330,12 +976,24 @@ void TurboSetModel::onStepMovedDown(Step *step)
     if (itNext == m_steps.end())
         return; // Already bottom element, nothing to do
 
+    size_t from = it - m_steps.begin();
+    notifyAboutToMove(nullptr, from, from + 1);
     std::iter_swap(it, itNext);
-    emit setChanged();
+    notifyMoved(nullptr, from, from + 1);
 }
 
 void TurboSetModel::onTypeChanged(Step *step, const StepType newType)
 {
+    if (!isEditable())
+        return;
+
+    if (step->parent())
+    {
+        if (!step->parent()->changeType(step, newType))
+            Q_ASSERT(false);
+        return;
+    }
+
     if (m_steps.empty())
     {
         Q_ASSERT(false);
@@ -354,17 +1012,27 @@ void TurboSetModel::onTypeChanged(Step *step, const StepType newType)
         return;
     }
 
-    if (newType == StepType::Loop)
-    {
-        delete *it;
-        *it = new LoopStep(this);
-    }
-    else
+    if ((newType == StepType::Loop) == ((*it)->type() == StepType::Loop))
     {
         (*it)->setType(newType);
+        notifyUpdated(*it);
+        return;
     }
 
-    emit setChanged();
+    // Switching between an interval and a loop needs a different kind of step.
+    size_t index = it - m_steps.begin();
+    notifyAboutToRemove(nullptr, index);
+
+    delete *it;
+    m_steps.erase(it);
+    notifyRemoved(nullptr, index);
+
+    notifyAboutToInsert(nullptr, index);
+    if (newType == StepType::Loop)
+        m_steps.insert(m_steps.begin() + index, new LoopStep(this));
+    else
+        m_steps.insert(m_steps.begin() + index, new Interval(newType, this));
+    notifyInserted(nullptr, index);
 }
 
 void TurboSetModel::onStepFinished()
@@ -378,6 +1046,9 @@ void TurboSetModel::onStepFinished()
     m_timer->stop();
     m_timeRemaining = -1;
 
+    if (m_currentInterval)
+        m_setElapsed += (int64_t)m_currentInterval->duration() * 1000;
+
     if (!m_currentStep)
     {
         Q_ASSERT(false);
@@ -436,8 +1107,28 @@ bool TurboSetModel::processXmlNode(QDomNode &node, LoopStep *parent)
     return true;
 }
 
+void TurboSetModel::forgetPendingChanges(Step *step)
+{
+    if (!step)
+        return;
+
+    m_pendingChanged.remove(step);
+
+    // Only look at children that exist, rather than loading a lazy loop just to forget it.
+    LoopStep *loop = dynamic_cast<LoopStep*>(step);
+    if (loop && loop->isMaterialised())
+    {
+        for (size_t i = 0; i < loop->getChildCount(); ++i)
+        {
+            forgetPendingChanges(loop->getChild(i));
+        }
+    }
+}
+
 void TurboSetModel::clearSet()
 {
+    m_pendingChanged.clear();
+
     for (auto step: m_steps)
     {
         delete step;
@@ -469,6 +1160,8 @@ Step* TurboSetModel::nextStep(Step *current)
 
     if (it == m_steps.end() || ++it == m_steps.end())
     {
+        // The set can be edited again once it has finished.
+        m_playbackState = PlaybackState::Ready;
         emit setComplete();
         resetPlaybackStates();
         return nullptr;
@@ -477,6 +1170,82 @@ Step* TurboSetModel::nextStep(Step *current)
     return *it;
 }
 
+size_t TurboSetModel::indexOf(Step *step) const
+{
+    if (step->parent())
+        return step->parent()->indexOf(step);
+
+    auto it = std::find(m_steps.begin(), m_steps.end(), step);
+    return it != m_steps.end() ? (size_t)(it - m_steps.begin()) : SIZE_MAX;
+}
+
+Step* TurboSetModel::takeStep(Step *step)
+{
+    size_t index = indexOf(step);
+    if (index == SIZE_MAX)
+    {
+        Q_ASSERT(false);
+        return nullptr;
+    }
+
+    if (step->parent())
+        return step->parent()->takeChild(index);
+
+    notifyAboutToRemove(nullptr, index);
+    m_steps.erase(m_steps.begin() + index);
+    notifyRemoved(nullptr, index);
+
+    return step;
+}
+
+void TurboSetModel::insertStep(LoopStep *parent, size_t index, Step *step)
+{
+    if (parent)
+    {
+        parent->insertChild(index, step);
+        return;
+    }
+
+    if (!step || index > m_steps.size())
+    {
+        Q_ASSERT(false);
+        return;
+    }
+
+    notifyAboutToInsert(nullptr, index);
+    step->setParent(nullptr);
+    m_steps.insert(m_steps.begin() + index, step);
+    notifyInserted(nullptr, index);
+}
+
+std::vector<Step*> TurboSetModel::outermostSteps(const std::vector<Step*> &steps)
+{
+    QSet<Step*> given;
+    for (auto step : steps)
+    {
+        given.insert(step);
+    }
+
+    std::vector<Step*> outermost;
+    QSet<Step*> seen;
+    for (auto step : steps)
+    {
+        if (seen.contains(step))
+            continue;
+        seen.insert(step);
+
+        bool covered = false;
+        for (LoopStep *loop = step->parent(); loop && !covered; loop = loop->parent())
+        {
+            covered = given.contains(loop);
+        }
+
+        if (!covered)
+            outermost.push_back(step);
+    }
+    return outermost;
+}
+
 void TurboSetModel::startCurrentStep()
 {
     if (!m_currentStep)
@@ -528,6 +1297,7 @@ void TurboSetModel::timeCurrentInterval()
 void TurboSetModel::resetPlaybackStates()
 {
     m_timeRemaining = -1;
+    m_setElapsed = 0;
 
     m_currentStep = nullptr;
     m_currentInterval = nullptr;
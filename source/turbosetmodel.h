@@ -9,14 +9,22 @@
 #include "step.h"
 #include "isetmanager.h"
 #include "istepmanager.h"
-#include <QAbstractListModel>
+#include <QAbstractItemModel>
 #include <QtXml/QDomElement>
+#include <QtXml/QDomDocument>
+#include <QSet>
 #include <vector>
 
 class QTimer;
 
-/*! Model object that manages the current set */
-class TurboSetModel : public QAbstractListModel, public IStepManager, public ISetManager
+/*!
+ * Model object that manages the current set.
+ *
+ * Also exposed as a hierarchical item model: top-level steps are rows of the root and
+ * each loop is the parent of its children. The children of a lazily-loaded loop are
+ * only created when a view fetches them, see canFetchMore()/fetchMore().
+ */
+class TurboSetModel : public QAbstractItemModel, public IStepManager, public ISetManager
 {
     Q_OBJECT
 
@@ -28,6 +36,45 @@ public:
         Paused
     };
 
+    //! How deserialise() treats the contents of loops.
+    enum class LoadMode
+    {
+        Eager,  //!< Create every step up front.
+        Lazy    //!< Create the children of a loop only when they are first needed, see LazySetLoader.
+    };
+
+    //! Item data roles, in addition to Qt::DisplayRole and Qt::EditRole.
+    enum Roles
+    {
+        TypeRole = Qt::UserRole + 1,    //!< StepType, as an int.
+        DurationRole,                   //!< Seconds, for loops the duration of one iteration.
+        TextRole,                       //!< Intervals only.
+        IterationsRole                  //!< Loops only.
+    };
+
+    /*!
+     * Groups edits for the lifetime of the object, see beginTransaction().
+     * Transactions nest, only the outermost commit notifies.
+     */
+    class Transaction
+    {
+    public:
+        explicit Transaction(TurboSetModel &model)
+            : m_model(model)
+        {
+            m_model.beginTransaction();
+        }
+
+        ~Transaction()
+        {
+            m_model.commitTransaction();
+        }
+
+    private:
+        Q_DISABLE_COPY(Transaction)
+        TurboSetModel &m_model;
+    };
+
     static const QString TurboSetTag;
     static const QString IntervalTag;
     static const QString LoopTag;
@@ -40,19 +87,94 @@ public:
 
     std::vector<Step*> getIntervals() const;
 
+    //! The step at index within parent, or within the top level of the set if parent is nullptr.
+    Step* childAt(Step *parent, size_t index) const;
+
     void addStep(StepType type, Step *parent = nullptr);
 
-    int rowCount(const QModelIndex &parent) const override;
+    //! The step an index refers to, nullptr for the root.
+    Step* stepForIndex(const QModelIndex &index) const;
+    QModelIndex indexForStep(Step *step) const;
 
+public: // QAbstractItemModel
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+public:
 
     bool serialise(const QString &file);
     bool deserialise(const QString &file);
     bool newSet();
 
+    //! Serialise the current set to an in-memory XML snapshot (UTF-8).
+    QByteArray toXml() const;
+
+    /*!
+     * Replace the current set with one parsed from an in-memory XML snapshot.
+     * \param data The XML content, as written by toXml()/serialise().
+     * \param errorMsg Optional, receives a description of the parse error on failure.
+     * \return true if the content could be parsed, false otherwise (the current set is left untouched).
+     */
+    bool fromXml(const QByteArray &data, QString *errorMsg = nullptr);
+
+    //! Replace the current set with the contents of an already-parsed document.
+    void fromDocument(const QDomDocument &doc);
+
+    /*!
+     * Replace the current set with steps built elsewhere, e.g. by an importer.
+     * The model takes ownership of the steps, which must have been created with this model as their manager.
+     * The set is marked dirty, as it has not been saved in this application's format.
+     */
+    void adoptSteps(const std::vector<Step*> &steps);
+
+    void setLoadMode(const LoadMode mode);
+    LoadMode loadMode() const;
+
     bool dirty() const;
+    void markDirty();
     bool isEmpty() const;
 
+    //! Query whether the set can be edited, which it can't while it's playing or paused.
+    bool isEditable() const;
+
+    //! Monotonic counter bumped on every modification, used to tell whether a snapshot is stale.
+    quint64 revision() const;
+
+    /*!
+     * Start batching edits. Until the matching commitTransaction(), setModified and dataChanged
+     * are held back and views that listen for transactionCommitted() can defer their updates,
+     * so a bulk edit produces one downstream update rather than one per step.
+     * Row insertions/removals are still reported as they happen, as item views require.
+     */
+    void beginTransaction();
+    void commitTransaction();
+    bool inTransaction() const;
+
+    /*!
+     * Bulk edits, each made in a single transaction so views update once.
+     * A step inside a loop that's also given is covered by its loop, and is otherwise ignored.
+     */
+    void scaleDurations(const std::vector<Step*> &steps, const double factor);
+    void changeTypes(const std::vector<Step*> &steps, const StepType newType);
+    void deleteSteps(const std::vector<Step*> &steps);
+
+    //! Move steps with the same parent into a new loop, in their current order, where the first of them was.
+    LoopStep* wrapInLoop(const std::vector<Step*> &steps);
+
+    //! Replace loops with a single copy of their children. Steps other than loops are ignored.
+    void unwrapLoops(const std::vector<Step*> &steps);
+
+    //! Query whether steps can be wrapped in a loop together, i.e. they share a parent.
+    static bool areSiblings(const std::vector<Step*> &steps);
+
     void startSet();
     void pauseSet();
     void stopSet();
@@ -60,14 +182,37 @@ public:
 
 public: // IStepManager
     virtual void notifyChange(bool redrawNeeded = false) override;
+    virtual void notifyAboutToInsert(Step *parent, size_t index) override;
+    virtual void notifyInserted(Step *parent, size_t index) override;
+    virtual void notifyAboutToRemove(Step *parent, size_t index) override;
+    virtual void notifyRemoved(Step *parent, size_t index) override;
+    virtual void notifyAboutToMove(Step *parent, size_t from, size_t to) override;
+    virtual void notifyMoved(Step *parent, size_t from, size_t to) override;
+    virtual void notifyAboutToMaterialise(Step *loop, size_t childCount) override;
+    virtual void notifyMaterialised(Step *loop) override;
+    virtual void notifyDataChanged(Step *step) override;
+    virtual void notifyUpdated(Step *step) override;
 
 public: // ISetManager
     virtual Interval* currentInterval() override;
     virtual Interval* nextInterval() override;
     virtual bool currentIteration(uint32_t &current, uint32_t &total) override;
+    virtual bool playbackProgress(PlaybackProgress &progress) override;
 
 signals:
+    //! The whole set was replaced (new, opened, imported...).
     void setChanged();
+    void setModified();
+
+    // Changes to individual steps, parent is nullptr for the top level of the set.
+    void stepInserted(Step *parent, int index);
+    void stepAboutToBeRemoved(Step *parent, int index);
+    void stepRemoved(Step *parent, int index);
+    void stepMoved(Step *parent, int from, int to);
+    void stepUpdated(Step *step);
+
+    //! The outermost transaction has been committed and its held-back notifications sent.
+    void transactionCommitted();
     void setStarted();
     void intervalStarted();
     void setPaused();
@@ -76,19 +221,29 @@ signals:
     void setStopped();
     void playbackError(const QString &error);
 
-protected slots:
+public slots:
+    // Edits requested by views, for steps at any depth.
     void onStepDeleted(Step *step);
     void onStepMovedUp(Step *step);
     void onStepMovedDown(Step *step);
     void onTypeChanged(Step *step, const StepType newType);
+
+protected slots:
     void onStepFinished();
 
 protected:
     bool processXmlNode(QDomNode &node, LoopStep *parent);
+    void forgetPendingChanges(Step *step);
+    bool loadLazy(const QByteArray &data);
     void clearSet();
 
     Step* nextStep(Step *current);
 
+    size_t indexOf(Step *step) const;
+    Step* takeStep(Step *step);
+    void insertStep(LoopStep *parent, size_t index, Step *step);
+    static std::vector<Step*> outermostSteps(const std::vector<Step*> &steps);
+
     void startCurrentStep();
     void timeCurrentInterval();
     void resetPlaybackStates();
@@ -96,11 +251,20 @@ protected:
 protected:
     std::vector<Step*> m_steps;
     bool m_dirty;
+    quint64 m_revision;
+    LoadMode m_loadMode;
+    bool m_resetting;
+    bool m_materialising;
+    int m_transactionDepth;
+    bool m_pendingModified;
+    QSet<Step*> m_pendingChanged;
     Step *m_currentStep;
     Interval *m_currentInterval;
     Interval *m_nextInterval;
     QTimer *m_timer;
     int m_timeRemaining;
+    int64_t m_setElapsed;   //!< ms, of the intervals already finished
+    int64_t m_setDuration;  //!< ms, loops expanded
     PlaybackState m_playbackState;
 };
 
@@ -4,6 +4,7 @@
 
 #include "upnextwidget.h"
 #include "stepresources.h"
+#include "framescheduler.h"
 #include <QPainter>
 #include <QTime>
 
@@ -65,7 +66,7 @@ void UpNextWidget::setInterval(Interval *upNext)
     DrawFaIconToLabel(m_icon, TypeToFaIcon(upNext->type()), m_fontAwesome);
 
     adjustLayout();
-    repaint();
+    FrameScheduler::instance().schedule(this);
 }
 
 void UpNextWidget::adjustLayout()
@@ -0,0 +1,724 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#include "workoutimporter.h"
+#include "turbosetmodel.h"
+#include "step.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QSet>
+#include <QTextStream>
+#include <QXmlStreamReader>
+#include <QRegExp>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const double DefaultFtp      = 200.0;    // Watts, used when an ERG file doesn't state one
+static const double EffortPercent   = 88.0;     // At or above this is an effort
+static const double RecoveryPercent = 60.0;     // At or below this is recovery
+static const double EasyPercent     = 75.0;     // Below this at the start/end of a workout is warm-up/cool-down
+
+/*! A step as read from a workout file, before it's turned into a Step */
+struct ImportedStep
+{
+    ImportedStep()
+        : type(StepType::Drill)
+        , duration(0)
+        , iterations(1)
+    {
+    }
+
+    bool operator==(const ImportedStep &other) const
+    {
+        return type == other.type
+                && duration == other.duration
+                && text == other.text
+                && iterations == other.iterations
+                && children == other.children;
+    }
+
+    bool operator!=(const ImportedStep &other) const
+    {
+        return !(*this == other);
+    }
+
+    StepType type;
+    unsigned int duration;
+    QString text;
+    unsigned int iterations;
+    std::vector<ImportedStep> children;
+};
+
+/*! A stretch of constant or linearly changing power, in percent of FTP */
+struct Segment
+{
+    unsigned int duration;
+    double start;
+    double end;
+    QString label;  //!< Optional name from the source (e.g. "Free ride")
+    QString cue;    //!< Optional text to show during the segment
+    StepType type;  //!< Set if the source says what kind of segment it is, otherwise Loop (= classify)
+};
+
+static void addWarning(QStringList *warnings, const QString &warning)
+{
+    if (warnings)
+        warnings->append(warning);
+}
+
+static void setError(QString *errorMsg, const QString &error)
+{
+    if (errorMsg)
+        *errorMsg = error;
+}
+
+static StepType ClassifySegment(const Segment &segment, const bool first, const bool last)
+{
+    if (segment.type != StepType::Loop)
+        return segment.type;
+
+    double average = (segment.start + segment.end) / 2.0;
+
+    if (first && (segment.end > segment.start + 1.0 || average < EasyPercent))
+        return StepType::WarmUp;
+
+    if (last && (segment.end < segment.start - 1.0 || average < EasyPercent))
+        return StepType::CoolDown;
+
+    if (average >= EffortPercent)
+        return StepType::Effort;
+
+    if (average <= RecoveryPercent)
+        return StepType::Recovery;
+
+    return StepType::Drill;
+}
+
+static QString DescribeSegment(const Segment &segment)
+{
+    QString text;
+    if (!segment.label.isEmpty())
+        text = segment.label;
+    else if (std::fabs(segment.end - segment.start) < 1.0)
+        text = QString("%1% FTP").arg(qRound(segment.start));
+    else
+        text = QString("Ramp %1% to %2% FTP").arg(qRound(segment.start)).arg(qRound(segment.end));
+
+    if (!segment.cue.isEmpty())
+        text += " - " + segment.cue;
+
+    return text;
+}
+
+static std::vector<ImportedStep> SegmentsToSteps(const std::vector<Segment> &segments)
+{
+    std::vector<ImportedStep> steps;
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        ImportedStep step;
+        step.type = ClassifySegment(segments[i], i == 0, i + 1 == segments.size());
+        step.duration = segments[i].duration;
+        step.text = DescribeSegment(segments[i]);
+        steps.push_back(step);
+    }
+    return steps;
+}
+
+/*!
+ * Fold runs of repeated steps into loops, e.g. A B C B C B C D -> A (B C)x3 D.
+ * Greedy from the left, at each position picking the block length that covers the most steps.
+ */
+static std::vector<ImportedStep> FoldRepeats(const std::vector<ImportedStep> &steps)
+{
+    std::vector<ImportedStep> folded;
+    size_t count = steps.size();
+    size_t i = 0;
+
+    while (i < count)
+    {
+        size_t bestLength = 1;
+        size_t bestRepeats = 1;
+
+        for (size_t length = 1; i + (length * 2) <= count; ++length)
+        {
+            size_t repeats = 1;
+            while (i + ((repeats + 1) * length) <= count
+                   && std::equal(steps.begin() + i, steps.begin() + i + length, steps.begin() + i + (repeats * length)))
+            {
+                ++repeats;
+            }
+
+            if (repeats > 1 && (repeats * length) > (bestRepeats * bestLength))
+            {
+                bestLength = length;
+                bestRepeats = repeats;
+            }
+        }
+
+        if (bestRepeats == 1)
+        {
+            folded.push_back(steps[i]);
+            ++i;
+            continue;
+        }
+
+        ImportedStep loop;
+        loop.type = StepType::Loop;
+        loop.iterations = (unsigned int)bestRepeats;
+        loop.children = FoldRepeats(std::vector<ImportedStep>(steps.begin() + i, steps.begin() + i + bestLength));
+        folded.push_back(loop);
+
+        i += bestLength * bestRepeats;
+    }
+
+    return folded;
+}
+
+static Step* CreateStep(const ImportedStep &imported, IStepManager *manager)
+{
+    if (imported.type == StepType::Loop)
+    {
+        LoopStep *loop = new LoopStep(manager);
+        loop->setIterations(imported.iterations);
+        for (const ImportedStep &child : imported.children)
+        {
+            loop->addChild(CreateStep(child, manager));
+        }
+        return loop;
+    }
+
+    Interval *interval = new Interval(imported.type, manager);
+    interval->setDuration(imported.duration);
+    interval->setText(imported.text);
+    return interval;
+}
+
+static void AdoptSteps(const std::vector<ImportedStep> &imported, TurboSetModel &model)
+{
+    // Building the steps edits each one several times, that shouldn't reach views one at a time.
+    TurboSetModel::Transaction transaction(model);
+
+    std::vector<Step*> steps;
+    for (const ImportedStep &step : imported)
+    {
+        steps.push_back(CreateStep(step, &model));
+    }
+    model.adoptSteps(steps);
+}
+
+static bool ImportErg(QIODevice &device, const bool percent, std::vector<ImportedStep> &steps, QString *errorMsg, QStringList *warnings)
+{
+    enum class Section
+    {
+        None,
+        Header,
+        Data,
+        Text
+    };
+
+    struct Point
+    {
+        double minutes;
+        double value;
+    };
+
+    struct Cue
+    {
+        double seconds;
+        QString text;
+    };
+
+    static const QRegExp Whitespace("\\s+");
+
+    Section section = Section::None;
+    bool inPercent = percent;
+    double ftp = 0.0;
+    std::vector<Point> points;
+    std::vector<Cue> cues;
+
+    QTextStream in(&device);
+    while (!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith(';'))
+            continue;
+
+        if (line.startsWith('['))
+        {
+            QString upper = line.toUpper();
+            if (upper.contains("END"))
+                section = Section::None;
+            else if (upper.contains("COURSE HEADER"))
+                section = Section::Header;
+            else if (upper.contains("COURSE DATA"))
+                section = Section::Data;
+            else if (upper.contains("COURSE TEXT"))
+                section = Section::Text;
+            continue;
+        }
+
+        switch (section)
+        {
+        case Section::Header:
+        {
+            int equals = line.indexOf('=');
+            if (equals >= 0)
+            {
+                if (line.left(equals).trimmed().compare("FTP", Qt::CaseInsensitive) == 0)
+                    ftp = line.mid(equals + 1).trimmed().toDouble();
+            }
+            else if (line.contains("PERCENT", Qt::CaseInsensitive))
+            {
+                inPercent = true;
+            }
+            else if (line.contains("WATTS", Qt::CaseInsensitive))
+            {
+                inPercent = false;
+            }
+            break;
+        }
+        case Section::Data:
+        {
+            QStringList parts = line.split(Whitespace, QString::SkipEmptyParts);
+            bool okTime = false, okValue = false;
+            Point point;
+            if (parts.size() >= 2)
+            {
+                point.minutes = parts.at(0).toDouble(&okTime);
+                point.value = parts.at(1).toDouble(&okValue);
+            }
+
+            if (okTime && okValue)
+                points.push_back(point);
+            else
+                addWarning(warnings, QString("Skipped unreadable course data '%1'").arg(line));
+            break;
+        }
+        case Section::Text:
+        {
+            QStringList parts = line.split('\t', QString::SkipEmptyParts);
+            bool ok = false;
+            Cue cue;
+            if (parts.size() >= 2)
+                cue.seconds = parts.at(0).toDouble(&ok);
+
+            if (ok)
+            {
+                cue.text = parts.at(1).trimmed();
+                cues.push_back(cue);
+            }
+            break;
+        }
+        case Section::None:
+            break;
+        }
+    }
+
+    if (points.size() < 2)
+    {
+        setError(errorMsg, "No course data found");
+        return false;
+    }
+
+    if (!inPercent && ftp <= 0.0)
+    {
+        addWarning(warnings, QString("No FTP given, assuming %1 W").arg(DefaultFtp));
+        ftp = DefaultFtp;
+    }
+
+    double scale = inPercent ? 1.0 : (100.0 / ftp);
+
+    // Each pair of consecutive points is a segment; zero-length pairs are just steps in power.
+    std::vector<Segment> segments;
+    for (size_t i = 0; i + 1 < points.size(); ++i)
+    {
+        int duration = qRound((points[i + 1].minutes - points[i].minutes) * 60.0);
+        if (duration <= 0)
+            continue;
+
+        Segment segment;
+        segment.duration = (unsigned int)duration;
+        segment.start = points[i].value * scale;
+        segment.end = points[i + 1].value * scale;
+        segment.type = StepType::Loop;
+
+        double startSecs = points[i].minutes * 60.0;
+        for (const Cue &cue : cues)
+        {
+            if (cue.seconds >= startSecs && cue.seconds < startSecs + duration)
+                segment.cue = segment.cue.isEmpty() ? cue.text : (segment.cue + " / " + cue.text);
+        }
+
+        // Flat segments continuing at the same power are one interval.
+        if (!segments.empty())
+        {
+            Segment &prev = segments.back();
+            bool flat = std::fabs(prev.start - prev.end) < 1.0 && std::fabs(segment.start - segment.end) < 1.0;
+            if (flat && std::fabs(prev.end - segment.start) < 1.0 && segment.cue.isEmpty())
+            {
+                prev.duration += segment.duration;
+                continue;
+            }
+        }
+
+        segments.push_back(segment);
+    }
+
+    if (segments.empty())
+    {
+        setError(errorMsg, "Course data has no duration");
+        return false;
+    }
+
+    steps = FoldRepeats(SegmentsToSteps(segments));
+    return true;
+}
+
+static QString ZwoAttribute(const QXmlStreamAttributes &attributes, const QString &name)
+{
+    // Attribute names are capitalised inconsistently between tools.
+    for (const QXmlStreamAttribute &attribute : attributes)
+    {
+        if (attribute.name().compare(name, Qt::CaseInsensitive) == 0)
+            return attribute.value().toString();
+    }
+    return QString();
+}
+
+static double ZwoPower(const QXmlStreamAttributes &attributes, const QString &name, const double fallback)
+{
+    bool ok = false;
+    double power = ZwoAttribute(attributes, name).toDouble(&ok);
+    return ok ? power * 100.0 : fallback; // Fraction of FTP
+}
+
+static bool ImportZwo(QIODevice &device, std::vector<ImportedStep> &steps, QString *errorMsg, QStringList *warnings)
+{
+    QXmlStreamReader reader(&device);
+
+    if (!reader.readNextStartElement() || reader.name().compare(QLatin1String("workout_file"), Qt::CaseInsensitive) != 0)
+    {
+        setError(errorMsg, "Not a ZWO workout file");
+        return false;
+    }
+
+    // Explicit repeats (IntervalsT) are kept in order with the plain segments, so that
+    // only segments at the very start and end of the workout are treated as warm-up/cool-down.
+    struct Item
+    {
+        Segment segment;
+        ImportedStep loop;
+        bool isLoop;
+    };
+
+    std::vector<Item> items;
+    bool foundWorkout = false;
+
+    while (reader.readNextStartElement())
+    {
+        if (reader.name().compare(QLatin1String("workout"), Qt::CaseInsensitive) != 0)
+        {
+            reader.skipCurrentElement();
+            continue;
+        }
+
+        foundWorkout = true;
+
+        while (reader.readNextStartElement())
+        {
+            QString tag = reader.name().toString().toLower();
+            QXmlStreamAttributes attributes = reader.attributes();
+
+            // Text events are children of the segment they belong to.
+            QString cue;
+            while (reader.readNextStartElement())
+            {
+                if (reader.name().compare(QLatin1String("textevent"), Qt::CaseInsensitive) == 0)
+                {
+                    QString message = ZwoAttribute(reader.attributes(), "message");
+                    if (!message.isEmpty())
+                        cue = cue.isEmpty() ? message : (cue + " / " + message);
+                }
+                reader.skipCurrentElement();
+            }
+
+            Segment segment;
+            segment.duration = ZwoAttribute(attributes, "Duration").toUInt();
+            segment.type = StepType::Loop;
+            segment.cue = cue;
+
+            if (tag == "warmup" || tag == "cooldown" || tag == "ramp")
+            {
+                segment.start = ZwoPower(attributes, "PowerLow", 50.0);
+                segment.end = ZwoPower(attributes, "PowerHigh", segment.start);
+                if (tag == "warmup")
+                    segment.type = StepType::WarmUp;
+                else if (tag == "cooldown")
+                    segment.type = StepType::CoolDown;
+            }
+            else if (tag == "steadystate")
+            {
+                double low = ZwoPower(attributes, "PowerLow", 0.0);
+                double high = ZwoPower(attributes, "PowerHigh", low);
+                segment.start = segment.end = ZwoPower(attributes, "Power", (low + high) / 2.0);
+            }
+            else if (tag == "freeride")
+            {
+                segment.start = segment.end = 0.0;
+                segment.label = "Free ride";
+                segment.type = StepType::Drill;
+            }
+            else if (tag == "maxeffort")
+            {
+                segment.start = segment.end = 0.0;
+                segment.label = "Max effort";
+                segment.type = StepType::Effort;
+            }
+            else if (tag == "intervalst")
+            {
+                ImportedStep on;
+                on.type = StepType::Effort;
+                on.duration = ZwoAttribute(attributes, "OnDuration").toUInt();
+                on.text = DescribeSegment(Segment{on.duration, ZwoPower(attributes, "OnPower", 100.0), ZwoPower(attributes, "OnPower", 100.0), QString(), cue, StepType::Effort});
+
+                ImportedStep off;
+                off.type = StepType::Recovery;
+                off.duration = ZwoAttribute(attributes, "OffDuration").toUInt();
+                off.text = DescribeSegment(Segment{off.duration, ZwoPower(attributes, "OffPower", 50.0), ZwoPower(attributes, "OffPower", 50.0), QString(), QString(), StepType::Recovery});
+
+                ImportedStep loop;
+                loop.type = StepType::Loop;
+                loop.iterations = std::max(ZwoAttribute(attributes, "Repeat").toUInt(), 1u);
+                if (on.duration > 0)
+                    loop.children.push_back(on);
+                if (off.duration > 0)
+                    loop.children.push_back(off);
+
+                if (!loop.children.empty())
+                {
+                    Item item;
+                    item.loop = loop;
+                    item.isLoop = true;
+                    items.push_back(item);
+                }
+                continue;
+            }
+            else
+            {
+                addWarning(warnings, QString("Skipped unsupported segment <%1>").arg(tag));
+                continue;
+            }
+
+            if (segment.duration == 0)
+            {
+                addWarning(warnings, QString("Skipped <%1> with no duration").arg(tag));
+                continue;
+            }
+
+            Item item;
+            item.segment = segment;
+            item.isLoop = false;
+            items.push_back(item);
+        }
+    }
+
+    if (reader.hasError())
+    {
+        setError(errorMsg, QString("line %1: %2").arg(reader.lineNumber()).arg(reader.errorString()));
+        return false;
+    }
+
+    if (!foundWorkout || items.empty())
+    {
+        setError(errorMsg, "No workout segments found");
+        return false;
+    }
+
+    std::vector<ImportedStep> imported;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        if (items[i].isLoop)
+        {
+            imported.push_back(items[i].loop);
+            continue;
+        }
+
+        ImportedStep step;
+        step.type = ClassifySegment(items[i].segment, i == 0, i + 1 == items.size());
+        step.duration = items[i].segment.duration;
+        step.text = DescribeSegment(items[i].segment);
+        imported.push_back(step);
+    }
+
+    steps = FoldRepeats(imported);
+    return true;
+}
+
+WorkoutImporter::Format WorkoutImporter::formatForFile(const QString &path)
+{
+    QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "erg")
+        return Format::Erg;
+    if (suffix == "mrc")
+        return Format::Mrc;
+    if (suffix == "zwo")
+        return Format::Zwo;
+    return Format::Unknown;
+}
+
+QStringList WorkoutImporter::fileExtensions()
+{
+    return QStringList() << "erg" << "mrc" << "zwo";
+}
+
+bool WorkoutImporter::importFile(const QString &path, TurboSetModel &model, QString *errorMsg /*= nullptr*/, QStringList *warnings /*= nullptr*/)
+{
+    Format format = formatForFile(path);
+    if (format == Format::Unknown)
+    {
+        setError(errorMsg, "Unrecognised workout format");
+        return false;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        setError(errorMsg, file.errorString());
+        return false;
+    }
+
+    return importDevice(file, format, model, errorMsg, warnings);
+}
+
+bool WorkoutImporter::importDevice(QIODevice &device, const Format format, TurboSetModel &model, QString *errorMsg /*= nullptr*/, QStringList *warnings /*= nullptr*/)
+{
+    std::vector<ImportedStep> steps;
+    bool ok = false;
+
+    switch (format)
+    {
+    case Format::Erg:
+    case Format::Mrc:
+        ok = ImportErg(device, format == Format::Mrc, steps, errorMsg, warnings);
+        break;
+    case Format::Zwo:
+        ok = ImportZwo(device, steps, errorMsg, warnings);
+        break;
+    case Format::Unknown:
+        setError(errorMsg, "Unrecognised workout format");
+        break;
+    }
+
+    if (ok)
+        AdoptSteps(steps, model);
+
+    return ok;
+}
+
+/*! A workout to convert, where its set is written and anything the user should know about that */
+struct ImportJob
+{
+    QString path;
+    QString output;
+    QStringList notes;
+};
+
+/*! Functor used to map workout files onto the thread pool */
+struct ImportToSet
+{
+    typedef QString result_type;
+
+    //! Returns an empty string on success, otherwise a description of the problem.
+    QString operator()(const ImportJob &job) const
+    {
+        TurboSetModel model;
+        QString error;
+        QStringList warnings;
+
+        if (!WorkoutImporter::importFile(job.path, model, &error, &warnings))
+            return QString("%1: %2").arg(job.path, error);
+
+        if (!model.serialise(job.output))
+            return QString("%1: could not write %2").arg(job.path, job.output);
+
+        return QString();
+    }
+};
+
+static ImportJob PlanImport(const QString &path, const QDir &inputDir, const QDir &outputDir, QSet<QString> &taken)
+{
+    ImportJob job;
+    job.path = path;
+
+    // Sets are laid out as the workouts are, so workouts in different folders can share a name.
+    QFileInfo info(path);
+    QString base = QDir::cleanPath(inputDir.relativeFilePath(info.absolutePath()) + "/" + info.completeBaseName());
+    QString relative = base + ".tttset";
+
+    // Workouts in the same folder can still share a name (e.g. a.erg and a.zwo), later ones are numbered.
+    // Case is ignored, as it is by some file systems.
+    for (int n = 2; taken.contains(relative.toLower()); ++n)
+    {
+        relative = QString("%1 (%2).tttset").arg(base).arg(n);
+    }
+    taken.insert(relative.toLower());
+
+    job.output = outputDir.absoluteFilePath(relative);
+    if (relative != base + ".tttset")
+        job.notes << QString("%1: saved as %2, as another workout has the same name").arg(path, job.output);
+    if (QFileInfo::exists(job.output))
+        job.notes << QString("%1: replaced the existing %2").arg(path, job.output);
+
+    return job;
+}
+
+WorkoutImporter::FolderResult WorkoutImporter::importFolder(const QString &folder, const QString &outputDir)
+{
+    QStringList filters;
+    for (const QString &ext : fileExtensions())
+    {
+        filters << ("*." + ext);
+    }
+
+    QStringList files;
+    QDirIterator it(folder, filters, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+    {
+        files << it.next();
+    }
+
+    // Outputs are decided up front, so clashes between them are found before anything is written.
+    QDir inputDir(folder);
+    QDir output(outputDir);
+    QSet<QString> taken;
+    QList<ImportJob> jobs;
+    for (const QString &file : files)
+    {
+        ImportJob job = PlanImport(file, inputDir, output, taken);
+        QDir().mkpath(QFileInfo(job.output).absolutePath());
+        jobs << job;
+    }
+
+    FolderResult result;
+    QStringList messages = QtConcurrent::blockingMapped<QStringList>(jobs, ImportToSet());
+    for (int i = 0; i < messages.size(); ++i)
+    {
+        if (messages[i].isEmpty())
+        {
+            ++result.imported;
+            result.messages << jobs[i].notes;
+        }
+        else
+        {
+            ++result.failed;
+            result.messages << messages[i];
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,77 @@
+/*************************************
+ * Copyright (C) 2017 Michael Pearce *
+ *************************************/
+
+#ifndef WORKOUTIMPORTER_H
+#define WORKOUTIMPORTER_H
+
+#include <QString>
+#include <QStringList>
+
+class QIODevice;
+class TurboSetModel;
+
+/*!
+ * Imports structured workouts from other platforms into a set.
+ *
+ * Supported formats:
+ * - ERG/MRC: plain-text course files, a list of (minutes, watts) or (minutes, percent of FTP) points.
+ * - ZWO: Zwift-style XML workouts (Warmup, SteadyState, IntervalsT, Ramp, FreeRide, MaxEffort, Cooldown).
+ *
+ * Both are read as streams, line by line or token by token. Segments are mapped onto interval types by
+ * their intensity and position, and runs of repeated segments are folded into loops.
+ */
+class WorkoutImporter
+{
+public:
+    enum class Format
+    {
+        Unknown,
+        Erg,
+        Mrc,
+        Zwo
+    };
+
+    /*! The outcome of importing a folder of workouts */
+    struct FolderResult
+    {
+        FolderResult()
+            : imported(0)
+            , failed(0)
+        {
+        }
+
+        int imported;
+        int failed;
+        QStringList messages;   //!< One line per file with a problem, or whose set was renamed or replaced an existing one.
+    };
+
+    //! Determine the format of a file from its extension.
+    static Format formatForFile(const QString &path);
+
+    //! The file extensions that can be imported.
+    static QStringList fileExtensions();
+
+    /*!
+     * Import a workout file, replacing the contents of the model.
+     * \param path The file to import.
+     * \param model The model to import into.
+     * \param errorMsg Optional, receives a description of the problem on failure.
+     * \param warnings Optional, receives anything that was approximated or skipped during import.
+     */
+    static bool importFile(const QString &path, TurboSetModel &model, QString *errorMsg = nullptr, QStringList *warnings = nullptr);
+
+    //! Import a workout of the given format from a device.
+    static bool importDevice(QIODevice &device, const Format format, TurboSetModel &model, QString *errorMsg = nullptr, QStringList *warnings = nullptr);
+
+    /*!
+     * Import every workout in a folder (recursively), writing each one out as a set.
+     * Files are spread across the global thread pool, and only one workout per thread is held in memory.
+     * Sets are written to the same subfolders of outputDir as their workouts are in within folder.
+     * \param folder The folder to search for workouts.
+     * \param outputDir Where to write the converted sets.
+     */
+    static FolderResult importFolder(const QString &folder, const QString &outputDir);
+};
+
+#endif // WORKOUTIMPORTER_H